@@ -0,0 +1,131 @@
+/*
+Copyright 2018 Oleg Skoromnik
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/*
+ *Counts heap allocations per call of the zeroth order sums on all
+ *ground state configurations of atomic_data, after one warm-up sweep
+ *that loads the databases and sizes the per-thread buffers. The
+ *serial v_total is expected to make none, the exit status is
+ *nonzero otherwise.
+ *
+ *    effz_bench_allocations [sweeps]
+ */
+
+#include "effz_atomic_data.h"
+#include "effz_integral_database.h"
+#include "effz_zeroth_order.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <new>
+#include <string>
+
+namespace {
+
+	std::atomic<std::size_t> num_allocations(0);
+
+} /* end anonymous namespace */
+
+void* operator new(std::size_t size)
+{
+	++num_allocations;
+	if(void *p = std::malloc(size == 0 ? 1 : size)){
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+	std::free(p);
+}
+
+namespace {
+
+	/*
+	 *allocations and seconds per call of f(z, g) over all
+	 *configurations, sweeps times
+	 */
+	template<typename Function>
+		void measure(const std::string &name,
+				const int sweeps,
+				const Function &f,
+				double &allocations_per_call)
+		{
+			const auto &g = effz::atomic_data::occ_nums_data::g;
+			double sum = 0.;
+			const std::size_t start_count = num_allocations;
+			const auto start = std::chrono::steady_clock::now();
+			for(int s = 0; s < sweeps; ++s){
+				for(std::size_t i = 0; i < g.size(); ++i){
+					sum += f(static_cast<double>(i + 1), g[i]);
+				}
+			}
+			const double seconds = std::chrono::duration<double>(
+					std::chrono::steady_clock::now() - start).count();
+			const double num_calls = static_cast<double>(sweeps)
+				* static_cast<double>(g.size());
+			allocations_per_call =
+				(num_allocations - start_count) / num_calls;
+			std::cout << name << ": " << allocations_per_call
+				<< " allocations/call, " << 1e6 * seconds / num_calls
+				<< " us/call (sum " << sum << ")\n";
+		}
+
+} /* end anonymous namespace */
+
+int main(int argc, char *argv[]) try {
+
+	using namespace effz::zeroth_order;
+	const int sweeps = argc > 1 ? std::stoi(argv[1]) : 10;
+
+	preload_databases();
+	double warm_up = 0.;
+	for(const auto &g: effz::atomic_data::occ_nums_data::g){
+		warm_up += v_total(g) + v_total_par(g);
+	}
+
+	double v_total_allocations = 0.;
+	double other_allocations = 0.;
+	measure("v_total", sweeps,
+			[](const double, const effz::occ_nums_array &g){
+				return v_total(g);
+			}, v_total_allocations);
+	measure("e_0th", sweeps,
+			[](const double z, const effz::occ_nums_array &g){
+				return e_0th(z, g);
+			}, other_allocations);
+	measure("v_total_par", sweeps,
+			[](const double, const effz::occ_nums_array &g){
+				return v_total_par(g);
+			}, other_allocations);
+
+	return v_total_allocations == 0. ? EXIT_SUCCESS : EXIT_FAILURE;
+
+} catch(const std::exception &e){
+	std::cerr << e.what() << "\n";
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,404 @@
+/*
+Copyright 2018 Oleg Skoromnik
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/*
+ *effz_build_db computes the i_direct and i_exchange tables of one
+ *precision tier for all orbitals n <= n_max, l <= min(n - 1, l_max).
+ *
+ *Completed entries are appended to <table>.build.journal every
+ *--checkpoint integrals, so a killed build resumes where it stopped
+ *when started again with the same arguments. The file is not the
+ *<table>.journal of the library, which a process loading the table
+ *merges and removes. Entries of a table that was already published
+ *at the same place are kept, so a build can also extend it to a
+ *larger n_max. At the end <table>.bin and <table>.txt are written
+ *next to the target and renamed, and the checkpoint is removed.
+ *
+ *The tables go to the database directory under the names the
+ *library loads by default, unless --dir is given.
+ *
+ *--timings writes the estimated cost and the measured time of every
+ *computed entry, and a summary of measured time per unit of
+ *estimated cost is printed, to check the cost model.
+ */
+
+#include "effz_config.h"
+#include "effz_integral_database.h"
+#include "effz_precision.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using namespace effz;
+using namespace effz::zeroth_order;
+
+namespace {
+
+	struct build_options{
+		int n_max = 7;
+		int l_max = 6;
+		precision_tier tier = precision_tier::standard;
+		std::size_t checkpoint = 256;
+		bool is_direct = true;
+		bool is_exchange = true;
+		std::string dir;
+		std::string timings_path;
+	};
+
+	void print_usage(std::ostream &s)
+	{
+		s << "usage: effz_build_db [options]\n"
+			<< "  --n-max N          largest principal number (7)\n"
+			<< "  --l-max L          largest orbital number (6)\n"
+			<< "  --tier T           fast, standard or reference"
+			<< " (standard)\n"
+			<< "  --kind K           direct, exchange or both (both)\n"
+			<< "  --checkpoint M     integrals between checkpoints (256)\n"
+			<< "  --dir D            output directory (database dir)\n"
+			<< "  --timings F        write estimated cost and seconds of"
+			<< " every entry to F\n";
+	}
+
+	precision_tier parse_tier(const std::string &name)
+	{
+		if(name == "fast"){
+			return precision_tier::fast;
+		}
+		if(name == "standard"){
+			return precision_tier::standard;
+		}
+		if(name == "reference"){
+			return precision_tier::reference;
+		}
+		throw std::invalid_argument("unknown precision tier " + name);
+	}
+
+	build_options parse_options(const int argc, char *argv[])
+	{
+		build_options options;
+		for(int i = 1; i < argc; ++i){
+			const std::string arg = argv[i];
+			if(arg == "-h" || arg == "--help"){
+				print_usage(std::cout);
+				std::exit(EXIT_SUCCESS);
+			}
+			if(i + 1 >= argc){
+				throw std::invalid_argument("missing value of " + arg);
+			}
+			const std::string value = argv[++i];
+			if(arg == "--n-max"){
+				options.n_max = std::stoi(value);
+			} else if(arg == "--l-max"){
+				options.l_max = std::stoi(value);
+			} else if(arg == "--tier"){
+				options.tier = parse_tier(value);
+			} else if(arg == "--kind"){
+				options.is_direct = value == "direct" || value == "both";
+				options.is_exchange = value == "exchange"
+					|| value == "both";
+				if(!options.is_direct && !options.is_exchange){
+					throw std::invalid_argument("unknown kind " + value);
+				}
+			} else if(arg == "--checkpoint"){
+				options.checkpoint = std::stoul(value);
+			} else if(arg == "--dir"){
+				options.dir = value;
+			} else if(arg == "--timings"){
+				options.timings_path = value;
+			} else {
+				throw std::invalid_argument("unknown option " + arg);
+			}
+		}
+		if(options.n_max < 1 || options.l_max < 0
+				|| options.checkpoint == 0){
+			throw std::invalid_argument(
+					"n_max >= 1, l_max >= 0 and checkpoint >= 1 required");
+		}
+		return options;
+	}
+
+	/*
+	 *the keys calculate_database uses, for the given n_max, l_max
+	 */
+	std::vector<std::array<int,5>> table_keys(
+			const integral_kind kind,
+			const int n_max,
+			const int l_max)
+	{
+		std::vector<std::array<int,5>> keys;
+		for(int n = 1; n <= n_max; ++n){
+			for(int l = 0; l <= std::min(n - 1, l_max); ++l){
+				for(int n1 = 1; n1 <= n_max; ++n1){
+					for(int l1 = 0; l1 <= std::min(n1 - 1, l_max); ++l1){
+						if(kind == integral_kind::direct){
+							for(int k = 0; k <= std::min(l,l1); ++k){
+								keys.push_back({n,l,n1,l1,2*k});
+							}
+						} else {
+							for(int k = std::abs(l-l1); k <= l+l1; ++k){
+								keys.push_back({n,l,n1,l1,k});
+							}
+						}
+					}
+				}
+			}
+		}
+		return keys;
+	}
+
+	bool is_readable(const std::string &path)
+	{
+		return std::ifstream(path).good();
+	}
+
+	/*
+	 *cost weighted progress, the expensive entries come first
+	 */
+	void print_progress(
+			const std::string &name,
+			const std::size_t num_done,
+			const std::size_t num_total,
+			const std::size_t num_computed,
+			const double cost_done,
+			const double cost_total,
+			const double seconds)
+	{
+		const double rate = seconds > 0. ? num_computed / seconds : 0.;
+		const double eta = cost_done > 0.
+			? seconds * (cost_total - cost_done) / cost_done : 0.;
+		std::cout << name << ": " << num_done << "/" << num_total
+			<< std::fixed << std::setprecision(1)
+			<< " (" << 100. * num_done / std::max<std::size_t>(num_total,1)
+			<< "%), " << rate << " integrals/s, "
+			<< seconds << " s elapsed, eta " << eta << " s"
+			<< std::defaultfloat << std::endl;
+	}
+
+	/*
+	 *quantiles of the measured seconds per unit of estimated cost,
+	 *a narrow spread means the model orders the entries well
+	 */
+	void print_cost_model(
+			const std::string &name,
+			const std::vector<build_timing> &timings)
+	{
+		std::vector<double> ratios;
+		double seconds = 0.;
+		for(const auto &t: timings){
+			seconds += t.seconds;
+			if(t.estimated_cost > 0.){
+				ratios.push_back(t.seconds / t.estimated_cost);
+			}
+		}
+		if(ratios.empty()){
+			return;
+		}
+		std::sort(ratios.begin(), ratios.end());
+		auto quantile = [&ratios](const double q){
+			return ratios[static_cast<std::size_t>(
+					q * static_cast<double>(ratios.size() - 1))];
+		};
+		std::cout << name << ": " << timings.size() << " entries, "
+			<< seconds << " s of work, seconds per unit cost 10% "
+			<< quantile(0.1) << ", median " << quantile(0.5)
+			<< ", 90% " << quantile(0.9) << "\n";
+	}
+
+	void write_timings(
+			std::ostream &s,
+			const std::string &name,
+			const std::vector<build_timing> &timings)
+	{
+		for(const auto &t: timings){
+			s << name;
+			for(const int q: t.key){
+				s << " " << q;
+			}
+			s << " " << t.estimated_cost << " " << t.seconds << "\n";
+		}
+	}
+
+	void build(
+			const integral_kind kind,
+			const std::string &path_to_data,
+			const build_options &options,
+			std::ostream *timings_stream)
+	{
+		const std::string name = kind == integral_kind::direct
+			? "i_direct" : "i_exchange";
+		const precision_policy precision =
+			precision_policy::preset(options.tier);
+		const std::string binary_path = path_to_data + ".bin";
+
+		integral_table table(options.n_max, 2 * options.l_max);
+		if(is_readable(binary_path)){
+			for(const auto &el:
+					integral_table::map_binary(binary_path, kind).entries()){
+				table.insert(std::get<0>(el), std::get<1>(el));
+			}
+		}
+		integral_journal checkpoint(path_to_data + ".build.journal");
+		const std::size_t num_resumed = checkpoint.replay(table);
+
+		const std::vector<std::array<int,5>> keys =
+			table_keys(kind, options.n_max, options.l_max);
+		std::vector<std::array<int,5>> todo;
+		for(const auto &key: keys){
+			double value;
+			if(!table.find(key[0],key[1],key[2],key[3],key[4],value)){
+				todo.push_back(key);
+			}
+		}
+		std::cout << name << ": " << keys.size() << " integrals, "
+			<< keys.size() - todo.size() << " done ("
+			<< num_resumed << " from the checkpoint), "
+			<< todo.size() << " to compute\n";
+
+		/*
+		 *longest first over the whole build, every chunk is balanced
+		 *by parallel_map_by_cost and checkpointed when it is done
+		 */
+		auto cost = [kind, &precision](const std::array<int,5> &key){
+			return estimated_cost(kind, key, precision);
+		};
+		std::stable_sort(todo.begin(), todo.end(),
+				[&cost](const std::array<int,5> &a,
+					const std::array<int,5> &b){
+					return cost(a) > cost(b);
+				});
+		double cost_total = 0.;
+		for(const auto &key: todo){
+			cost_total += cost(key);
+		}
+
+		double cost_done = 0.;
+		std::vector<build_timing> timings;
+		const auto start = std::chrono::steady_clock::now();
+		for(std::size_t begin = 0; begin < todo.size();
+				begin += options.checkpoint){
+			const std::size_t end =
+				std::min(begin + options.checkpoint, todo.size());
+			const std::vector<std::array<int,5>> chunk(
+					todo.cbegin() + begin, todo.cbegin() + end);
+			std::vector<build_timing> chunk_timings;
+			const std::vector<double> values =
+				calculate_integrals(kind, chunk, precision, &chunk_timings);
+			timings.insert(timings.end(), chunk_timings.cbegin(),
+					chunk_timings.cend());
+
+			std::vector<std::pair<std::uint64_t,double>> records;
+			for(std::size_t i = 0; i < chunk.size(); ++i){
+				const auto &key = chunk[i];
+				table.insert(key, values[i]);
+				records.push_back({integral_table::pack(
+							key[0],key[1],key[2],key[3],key[4]),
+						values[i]});
+				cost_done += cost(key);
+			}
+			checkpoint.append(records);
+
+			print_progress(name, keys.size() - todo.size() + end,
+					keys.size(), end, cost_done, cost_total,
+					std::chrono::duration<double>(
+						std::chrono::steady_clock::now() - start).count());
+		}
+
+		print_cost_model(name, timings);
+		if(timings_stream != nullptr){
+			write_timings(*timings_stream, name, timings);
+		}
+
+		/*
+		 *the binary table first, it is all the library needs, then
+		 *the JSON export of the same entries. The runtime journal is
+		 *left to the library, which merges it on the next load.
+		 */
+		table.save_binary(binary_path, kind);
+		checkpoint.clear();
+		table.export_json(path_to_data + ".txt");
+		std::cout << name << ": " << table.size() << " integrals in "
+			<< binary_path << "\n";
+	}
+
+	/*
+	 *default_path(tier) with the directory replaced by dir
+	 */
+	std::string output_path(
+			const std::string &default_path,
+			const std::string &dir)
+	{
+		if(dir.empty()){
+			return default_path;
+		}
+		return dir + default_path.substr(default_path.rfind('/'));
+	}
+
+} /* end anonymous namespace */
+
+int main(int argc, char *argv[]) try {
+
+	const build_options options = parse_options(argc, argv);
+	if(options.dir.empty()){
+		config::shared_config().check_dirs();
+	}
+	std::ofstream timings_file;
+	if(!options.timings_path.empty()){
+		timings_file.open(options.timings_path,
+				std::ios::out | std::ios::trunc);
+		if(!timings_file.is_open()){
+			throw std::runtime_error("can not open "
+					+ options.timings_path);
+		}
+		timings_file << "# kind n l n1 l1 k estimated_cost seconds\n";
+	}
+	std::ostream *timings_stream =
+		timings_file.is_open() ? &timings_file : nullptr;
+
+	if(options.is_direct){
+		build(integral_kind::direct,
+				output_path(i_direct_database::default_path(options.tier),
+					options.dir),
+				options, timings_stream);
+	}
+	if(options.is_exchange){
+		build(integral_kind::exchange,
+				output_path(i_exchange_database::default_path(options.tier),
+					options.dir),
+				options, timings_stream);
+	}
+
+	return EXIT_SUCCESS;
+
+} catch(const std::exception &e){
+	std::cerr << e.what() << "\n";
+	print_usage(std::cerr);
+	return EXIT_FAILURE;
+} catch(...){
+	return EXIT_FAILURE;
+}
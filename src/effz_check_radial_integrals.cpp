@@ -0,0 +1,78 @@
+/*
+Copyright 2018 Oleg Skoromnik
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+
+/*
+ *Checks the closed form Slater integrals against exact values. The
+ *reference values are the doubles nearest to the rational results of
+ *the same sums in exact arithmetic (python fractions). At n = 7 the
+ *terms cancel by about eleven orders of magnitude, so rounding the
+ *coefficients to double alone used to cost nine digits here.
+ */
+
+#include "effz_radial_integrals.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+
+namespace {
+
+	struct exact_case{
+		char kind;
+		int n;
+		int l;
+		int n1;
+		int l1;
+		int k;
+		double value;
+	};
+
+	const exact_case exact_cases[] = {
+		{'D', 7, 0, 7, 0, 0, 1.21477185463418763e-02},
+		{'D', 7, 6, 7, 6, 12, 3.27583782526911539e-03},
+		{'D', 7, 3, 6, 2, 4, 3.99337050163843781e-03},
+		{'D', 1, 0, 7, 0, 0, 1.95059335632095099e-02},
+		{'E', 7, 0, 6, 0, 0, 1.08780427628321240e-03},
+		{'E', 7, 0, 7, 1, 1, 8.17723420201515658e-03},
+		{'E', 7, 6, 7, 5, 11, 2.05587063516889318e-03},
+		{'E', 7, 2, 5, 4, 2, 6.85776345988233318e-04}
+	};
+
+} /* end anonymous namespace */
+
+int main()
+{
+	const double eps = std::numeric_limits<double>::epsilon();
+	int num_failed = 0;
+	for(const exact_case &c: exact_cases){
+		double abserr = 0.;
+		const double value = c.kind == 'D'
+			? effz::radial::slater_direct(c.n,c.l,c.n1,c.l1,c.k,&abserr)
+			: effz::radial::slater_exchange(c.n,c.l,c.n1,c.l1,c.k,&abserr);
+		const double error = std::abs(value - c.value);
+		if(error > eps * std::abs(c.value) || error > abserr){
+			++num_failed;
+			std::cerr.precision(17);
+			std::cerr << c.kind << "(" << c.n << "," << c.l << ","
+				<< c.n1 << "," << c.l1 << "," << c.k << ") = " << value
+				<< ", exact " << c.value << ", reported error "
+				<< abserr << "\n";
+		}
+	}
+	return num_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
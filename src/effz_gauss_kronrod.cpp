@@ -0,0 +1,436 @@
+/*
+Copyright 2018 Oleg Skoromnik
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "effz_gauss_kronrod.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace effz{
+
+	namespace integration{
+
+		namespace {
+
+			/*
+			 *Kronrod abscissae on [0,1], odd entries are the Gauss
+			 *nodes, and weights from QUADPACK qk21
+			 */
+			const double xgk[11] = {
+				0.995657163025808080735527280689003,
+				0.973906528517171720077964012084452,
+				0.930157491355708226001207180059508,
+				0.865063366688984510732096688423493,
+				0.780817726586416897063717578345042,
+				0.679409568299024406234327365114874,
+				0.562757134668604683339000099272694,
+				0.433395394129247190799265943165784,
+				0.294392862701460198131126603103866,
+				0.148874338981631210884826001129720,
+				0.000000000000000000000000000000000};
+
+			const double wg[5] = {
+				0.066671344308688137593568809893332,
+				0.149451349150580593145776339657697,
+				0.219086362515982043995534934228163,
+				0.269266719309996355091226921569469,
+				0.295524224714752870173892994651338};
+
+			const double wgk[11] = {
+				0.011694638867371874278064396062192,
+				0.032558162307964727478818972459390,
+				0.054755896574351996031381300244580,
+				0.075039674810919952767043140916190,
+				0.093125454583697605535065465083366,
+				0.109387158802297641899210590325805,
+				0.123491976262065851077208292139839,
+				0.134709217311473325928054001771707,
+				0.142775938577060080797094273138717,
+				0.147739104901338491374841515972068,
+				0.149445554002916905664936468389821};
+
+			const std::size_t panel_size = 21;
+
+			struct panel{
+				double a;
+				double b;
+				double result;
+				double error;
+			};
+
+			bool operator<(const panel &p, const panel &q)
+			{
+				return p.error < q.error;
+			}
+
+			/*
+			 *nodes of [a,b]: c - h xgk[j] for j < 10, c, then
+			 *c + h xgk[j]
+			 */
+			void panel_nodes(const double a, const double b, double *x)
+			{
+				const double c = 0.5 * (a + b);
+				const double h = 0.5 * (b - a);
+				for(int j = 0; j < 10; ++j){
+					x[j] = c - h * xgk[j];
+					x[20 - j] = c + h * xgk[j];
+				}
+				x[10] = c;
+			}
+
+			/*
+			 *QUADPACK qk21 sums and error estimate from the values
+			 *on panel_nodes
+			 */
+			panel panel_rule(const double a, const double b,
+					const double *y)
+			{
+				const double h = 0.5 * (b - a);
+				const double f_c = y[10];
+				double res_k = f_c * wgk[10];
+				double res_g = 0.;
+				double res_abs = std::abs(res_k);
+				for(int j = 0; j < 10; ++j){
+					const double sum = y[j] + y[20 - j];
+					res_k += wgk[j] * sum;
+					res_abs += wgk[j] * (std::abs(y[j]) + std::abs(y[20 - j]));
+					if(j % 2 == 1){
+						res_g += wg[j / 2] * sum;
+					}
+				}
+				const double mean = 0.5 * res_k;
+				double res_asc = wgk[10] * std::abs(f_c - mean);
+				for(int j = 0; j < 10; ++j){
+					res_asc += wgk[j] * (std::abs(y[j] - mean)
+							+ std::abs(y[20 - j] - mean));
+				}
+				res_abs *= std::abs(h);
+				res_asc *= std::abs(h);
+
+				double error = std::abs((res_k - res_g) * h);
+				if(res_asc != 0. && error != 0.){
+					error = res_asc * std::min(1.,
+							std::pow(200. * error / res_asc, 1.5));
+				}
+				const double eps = std::numeric_limits<double>::epsilon();
+				if(res_abs > std::numeric_limits<double>::min()
+						/ (50. * eps)){
+					error = std::max(50. * eps * res_abs, error);
+				}
+				return panel{a, b, res_k * h, error};
+			}
+
+			/*
+			 *f on n nodes, with the map t -> a + (1 - t) / t and its
+			 *jacobian for an infinite upper limit
+			 */
+			void evaluate(panel_function f, void *params,
+					const bool is_infinite, const double a,
+					const double *t, double *y, const std::size_t n)
+			{
+				if(!is_infinite){
+					f(t, y, n, params);
+					return;
+				}
+				double x[max_panel_nodes];
+				for(std::size_t i = 0; i < n; ++i){
+					x[i] = a + (1. - t[i]) / t[i];
+				}
+				f(x, y, n, params);
+				for(std::size_t i = 0; i < n; ++i){
+					y[i] /= t[i] * t[i];
+				}
+			}
+
+			void evaluate_multi(multi_panel_function f, void *params,
+					const std::size_t num_components,
+					const bool is_infinite, const double a,
+					const double *t, double *y, const std::size_t n)
+			{
+				if(!is_infinite){
+					f(t, y, n, num_components, params);
+					return;
+				}
+				double x[max_panel_nodes];
+				for(std::size_t i = 0; i < n; ++i){
+					x[i] = a + (1. - t[i]) / t[i];
+				}
+				f(x, y, n, num_components, params);
+				for(std::size_t c = 0; c < num_components; ++c){
+					for(std::size_t i = 0; i < n; ++i){
+						y[c * n + i] /= t[i] * t[i];
+					}
+				}
+			}
+
+			/*
+			 *panel heaps of the calling thread, one per nesting level
+			 */
+			class panel_pool
+			{
+				public:
+					static std::vector<panel> borrow()
+					{
+						std::vector<std::vector<panel>> &free = local();
+						if(free.empty()){
+							return std::vector<panel>();
+						}
+						std::vector<panel> res = std::move(free.back());
+						free.pop_back();
+						res.clear();
+						return res;
+					}
+
+					static void release(std::vector<panel> &&panels)
+					{
+						local().push_back(std::move(panels));
+					}
+
+				private:
+					static std::vector<std::vector<panel>>& local()
+					{
+						thread_local std::vector<std::vector<panel>> free;
+						return free;
+					}
+			};
+
+		} /* end anonymous namespace */
+
+		double gk21_adaptive(
+				panel_function f,
+				void *params,
+				const double a,
+				const double b,
+				const double epsabs,
+				const double epsrel,
+				const std::size_t limit,
+				double *abserr)
+		{
+			const bool is_infinite = std::isinf(b);
+			const double lo = is_infinite ? 0. : a;
+			const double hi = is_infinite ? 1. : b;
+
+			double t[max_panel_nodes];
+			double y[max_panel_nodes];
+			panel_nodes(lo, hi, t);
+			evaluate(f, params, is_infinite, a, t, y, panel_size);
+
+			std::vector<panel> panels = panel_pool::borrow();
+			panels.push_back(panel_rule(lo, hi, y));
+			double result = panels.front().result;
+			double error = panels.front().error;
+
+			const double min_width = 1000. * std::numeric_limits<double>::epsilon();
+			while(error > std::max(epsabs, epsrel * std::abs(result))
+					&& panels.size() < std::max<std::size_t>(limit, 1)){
+				std::pop_heap(panels.begin(), panels.end());
+				const panel worst = panels.back();
+				panels.pop_back();
+				const double mid = 0.5 * (worst.a + worst.b);
+				if(std::abs(worst.b - worst.a) <= min_width
+						* (std::abs(worst.a) + std::abs(worst.b))){
+					/*
+					 *roundoff limit, nothing more to gain
+					 */
+					panels.push_back(worst);
+					std::push_heap(panels.begin(), panels.end());
+					break;
+				}
+				panel_nodes(worst.a, mid, t);
+				panel_nodes(mid, worst.b, t + panel_size);
+				evaluate(f, params, is_infinite, a, t, y, 2 * panel_size);
+				const panel left = panel_rule(worst.a, mid, y);
+				const panel right = panel_rule(mid, worst.b, y + panel_size);
+
+				result += left.result + right.result - worst.result;
+				error += left.error + right.error - worst.error;
+				panels.push_back(left);
+				std::push_heap(panels.begin(), panels.end());
+				panels.push_back(right);
+				std::push_heap(panels.begin(), panels.end());
+			}
+
+			/*
+			 *resum to drop the rounding of the running updates
+			 */
+			result = 0.;
+			error = 0.;
+			for(const auto &p: panels){
+				result += p.result;
+				error += p.error;
+			}
+			panel_pool::release(std::move(panels));
+			if(abserr != nullptr){
+				*abserr = error;
+			}
+			return result;
+		}
+
+		void gk21_adaptive_multi(
+				multi_panel_function f,
+				void *params,
+				const std::size_t num_components,
+				const double a,
+				const double b,
+				const double epsabs,
+				const double epsrel,
+				const std::size_t limit,
+				double *result,
+				double *abserr)
+		{
+			const std::size_t m = num_components;
+			const bool is_infinite = std::isinf(b);
+			const double lo = is_infinite ? 0. : a;
+			const double hi = is_infinite ? 1. : b;
+
+			/*
+			 *panel p covers [bounds[2p], bounds[2p+1]], its results
+			 *and errors are values[2 m p + c] and values[2 m p + m + c]
+			 */
+			std::vector<double> bounds;
+			std::vector<double> values;
+			std::vector<double> y(m * max_panel_nodes);
+			std::vector<double> tolerance(m);
+			double t[max_panel_nodes];
+
+			auto add_panel = [&](const double p_a, const double p_b,
+					const double *y_panel, const std::size_t stride){
+				bounds.push_back(p_a);
+				bounds.push_back(p_b);
+				const std::size_t offset = values.size();
+				values.resize(offset + 2 * m);
+				for(std::size_t c = 0; c < m; ++c){
+					const panel rule = panel_rule(p_a, p_b,
+							y_panel + c * stride);
+					values[offset + c] = rule.result;
+					values[offset + m + c] = rule.error;
+				}
+			};
+			auto sum_up = [&](double *res, double *err){
+				std::fill(res, res + m, 0.);
+				std::fill(err, err + m, 0.);
+				for(std::size_t p = 0; p < bounds.size() / 2; ++p){
+					for(std::size_t c = 0; c < m; ++c){
+						res[c] += values[2 * m * p + c];
+						err[c] += values[2 * m * p + m + c];
+					}
+				}
+			};
+
+			panel_nodes(lo, hi, t);
+			evaluate_multi(f, params, m, is_infinite, a, t, y.data(),
+					panel_size);
+			add_panel(lo, hi, y.data(), panel_size);
+
+			std::vector<double> total(m), error(m);
+			const double min_width =
+				1000. * std::numeric_limits<double>::epsilon();
+			for(;;){
+				sum_up(total.data(), error.data());
+				bool is_converged = true;
+				for(std::size_t c = 0; c < m; ++c){
+					tolerance[c] = std::max(epsabs,
+							epsrel * std::abs(total[c]));
+					is_converged = is_converged && error[c] <= tolerance[c];
+				}
+				const std::size_t num_panels = bounds.size() / 2;
+				if(is_converged || num_panels >= std::max<std::size_t>(limit, 1)){
+					break;
+				}
+
+				std::size_t worst = 0;
+				double worst_ratio = -1.;
+				for(std::size_t p = 0; p < num_panels; ++p){
+					for(std::size_t c = 0; c < m; ++c){
+						const double ratio =
+							values[2 * m * p + m + c] / tolerance[c];
+						if(ratio > worst_ratio){
+							worst_ratio = ratio;
+							worst = p;
+						}
+					}
+				}
+				const double p_a = bounds[2 * worst];
+				const double p_b = bounds[2 * worst + 1];
+				if(std::abs(p_b - p_a) <= min_width
+						* (std::abs(p_a) + std::abs(p_b))){
+					break;
+				}
+				const double mid = 0.5 * (p_a + p_b);
+				panel_nodes(p_a, mid, t);
+				panel_nodes(mid, p_b, t + panel_size);
+				evaluate_multi(f, params, m, is_infinite, a, t, y.data(),
+						2 * panel_size);
+
+				/*
+				 *the left half replaces the bisected panel
+				 */
+				std::vector<double> right(2 * m);
+				for(std::size_t c = 0; c < m; ++c){
+					const double *y_c = y.data() + c * 2 * panel_size;
+					const panel left = panel_rule(p_a, mid, y_c);
+					const panel r = panel_rule(mid, p_b, y_c + panel_size);
+					values[2 * m * worst + c] = left.result;
+					values[2 * m * worst + m + c] = left.error;
+					right[c] = r.result;
+					right[m + c] = r.error;
+				}
+				bounds[2 * worst + 1] = mid;
+				bounds.push_back(mid);
+				bounds.push_back(p_b);
+				values.insert(values.end(), right.begin(), right.end());
+			}
+
+			std::copy(total.begin(), total.end(), result);
+			if(abserr != nullptr){
+				std::copy(error.begin(), error.end(), abserr);
+			}
+		}
+
+		double decay_cutoff(const decay &d, const double r, const double eps)
+		{
+			const double degree = std::max(d.degree, 0.);
+			const double x_max = std::max(r, degree / d.alpha);
+			const double log_eps = std::log(eps);
+
+			/*
+			 *degree ln(R / x_max) - alpha (R - x_max) = ln(eps),
+			 *the fixed point iteration contracts for R > degree / alpha
+			 */
+			double cutoff = x_max - log_eps / d.alpha;
+			if(degree == 0.){
+				return cutoff;
+			}
+			for(int i = 0; i < 100; ++i){
+				const double next = x_max
+					+ (degree * std::log(cutoff / x_max) - log_eps) / d.alpha;
+				if(std::abs(next - cutoff) <= 1e-3 * cutoff){
+					return next;
+				}
+				cutoff = next;
+			}
+			return cutoff;
+		}
+
+		double decay_tail(const decay &d, const double cutoff)
+		{
+			return 1. / (d.alpha - std::max(d.degree, 0.) / cutoff);
+		}
+
+	} /*namespace integration*/
+} /*namespace effz*/
@@ -0,0 +1,294 @@
+/*
+Copyright 2018 Oleg Skoromnik
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef EFFZ_GAUSS_KRONROD_H
+#define EFFZ_GAUSS_KRONROD_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace effz{
+
+	namespace integration{
+
+		/*
+		 *integrand evaluated on a whole panel of nodes,
+		 *y[i] = f(x[i]) for 0 <= i < n <= max_panel_nodes
+		 */
+		const std::size_t max_panel_nodes = 42;
+
+		typedef void (*panel_function)(
+				const double *x,
+				double *y,
+				const std::size_t n,
+				void *params);
+
+		/*
+		 *Adaptive 21 point Gauss-Kronrod quadrature with the error
+		 *control of QUADPACK qag (as used by gsl_integration_qag):
+		 *the panel with the largest error is bisected until the sum
+		 *of the errors is below max(epsabs, epsrel |result|) or
+		 *limit panels are used. Both halves of a bisection are passed
+		 *to f in one call of 42 nodes.
+		 *
+		 *b may be +infinity, then x = a + (1 - t) / t maps the range
+		 *to t in (0,1] like gsl_integration_qagiu.
+		 */
+		double gk21_adaptive(
+				panel_function f,
+				void *params,
+				const double a,
+				const double b,
+				const double epsabs,
+				const double epsrel,
+				const std::size_t limit,
+				double *abserr = nullptr);
+
+		/*
+		 *f(const double *x, double *y, std::size_t n) as in
+		 *panel_function, the error estimate is stored in abserr if
+		 *it is not null
+		 */
+		template <typename F>
+			double quad_panels(
+					F f,
+					const std::pair<double,double> &range,
+					const double epsabs = 1.49e-8,
+					const double epsrel = 1.49e-8,
+					const std::size_t limit = 250,
+					double *abserr = nullptr)
+			{
+				auto wrapper = [](const double *x, double *y,
+						const std::size_t n, void *params){
+					(*static_cast<F*>(params))(x, y, n);
+				};
+				return gk21_adaptive(wrapper, &f,
+						range.first, range.second,
+						epsabs, epsrel, limit, abserr);
+			}
+
+		/*
+		 *num_components integrands on the same nodes,
+		 *y[c * n + i] = f_c(x[i]) for 0 <= c < num_components
+		 */
+		typedef void (*multi_panel_function)(
+				const double *x,
+				double *y,
+				const std::size_t n,
+				const std::size_t num_components,
+				void *params);
+
+		/*
+		 *gk21_adaptive for a family of integrands sharing one mesh.
+		 *Every component has its own tolerance
+		 *max(epsabs, epsrel |result_c|), the panel bisected next is
+		 *the one with the largest error relative to the tolerance of
+		 *its worst component. result and abserr (if not null) receive
+		 *num_components values.
+		 */
+		void gk21_adaptive_multi(
+				multi_panel_function f,
+				void *params,
+				const std::size_t num_components,
+				const double a,
+				const double b,
+				const double epsabs,
+				const double epsrel,
+				const std::size_t limit,
+				double *result,
+				double *abserr = nullptr);
+
+		/*
+		 *f(const double *x, double *y, std::size_t n) as in
+		 *multi_panel_function with num_components bound
+		 */
+		template <typename F>
+			std::vector<double> quad_panels_multi(
+					F f,
+					const std::size_t num_components,
+					const std::pair<double,double> &range,
+					const double epsabs = 1.49e-8,
+					const double epsrel = 1.49e-8,
+					const std::size_t limit = 250,
+					double *abserr = nullptr)
+			{
+				auto wrapper = [](const double *x, double *y,
+						const std::size_t n, const std::size_t,
+						void *params){
+					(*static_cast<F*>(params))(x, y, n);
+				};
+				std::vector<double> res(num_components);
+				gk21_adaptive_multi(wrapper, &f, num_components,
+						range.first, range.second,
+						epsabs, epsrel, limit, res.data(), abserr);
+				return res;
+			}
+
+		/*
+		 *large x behaviour x^degree exp(-alpha x) of an integrand,
+		 *e.g. alpha = 2/n and degree = 2n for r^2 h_rnl(n,l,r)^2.
+		 *A degree that is too large only moves the cutoff outwards.
+		 */
+		struct decay{
+			double alpha;
+			double degree;
+		};
+
+		/*
+		 *R > r beyond which x^degree exp(-alpha x) stays below eps
+		 *times its maximum over [r, inf)
+		 */
+		double decay_cutoff(const decay &d, const double r, const double eps);
+
+		/*
+		 *int_R^inf f(x) dx / f(R) for f(x) ~ x^degree exp(-alpha x),
+		 *the incomplete gamma function summed to first order,
+		 *1 / (alpha - degree / R). R has to come from decay_cutoff.
+		 */
+		double decay_tail(const decay &d, const double cutoff);
+
+		/*
+		 *int_r^inf of a panel integrand decaying like d. The range is
+		 *cut at decay_cutoff(d, r, epsrel) and the rest is added
+		 *analytically by decay_tail. Only if that tail is above the
+		 *tolerance, one more quadrature up to the next cutoff is done,
+		 *so there are never more than two calls of gk21_adaptive.
+		 *abserr gets the quadrature errors plus the size of the
+		 *analytic tail, which bounds the error of its estimate.
+		 */
+		template<typename F>
+			double int_r_inf_panels(
+					F f,
+					const double r,
+					const decay &d,
+					const double epsabs = 1.49e-8,
+					const double epsrel = 1.49e-8,
+					double *abserr = nullptr)
+			{
+				const double eps =
+					std::max(epsrel, std::numeric_limits<double>::epsilon());
+				double cutoff = decay_cutoff(d, r, eps);
+				double error = 0.;
+				double result = quad_panels(f, {r,cutoff}, epsabs, epsrel,
+						250, &error);
+				double f_cutoff;
+				f(&cutoff, &f_cutoff, 1);
+				double tail = f_cutoff * decay_tail(d, cutoff);
+				if(std::abs(tail) > std::max(epsabs, epsrel * std::abs(result))){
+					const double next_cutoff = decay_cutoff(d, cutoff, eps);
+					double residue_error = 0.;
+					result += quad_panels(f, {cutoff,next_cutoff},
+							epsabs, epsrel, 250, &residue_error);
+					error += residue_error;
+					cutoff = next_cutoff;
+					f(&cutoff, &f_cutoff, 1);
+					tail = f_cutoff * decay_tail(d, cutoff);
+				}
+
+				if(abserr != nullptr){
+					*abserr = error + std::abs(tail);
+				}
+				return result + tail;
+			}
+
+		template<typename F>
+			double int_0_inf_panels(
+					F f,
+					const decay &d,
+					const double epsabs = 1.49e-8,
+					const double epsrel = 1.49e-8,
+					double *abserr = nullptr)
+			{
+				return int_r_inf_panels(f, 0., d, epsabs, epsrel, abserr);
+			}
+
+		/*
+		 *int_r_inf_panels for families decaying like d, the second
+		 *quadrature is done if the tail of any component is above
+		 *its tolerance. abserr receives num_components values.
+		 */
+		template<typename F>
+			std::vector<double> int_r_inf_panels_multi(
+					F f,
+					const std::size_t num_components,
+					const double r,
+					const decay &d,
+					const double epsabs = 1.49e-8,
+					const double epsrel = 1.49e-8,
+					double *abserr = nullptr)
+			{
+				const double eps =
+					std::max(epsrel, std::numeric_limits<double>::epsilon());
+				double cutoff = decay_cutoff(d, r, eps);
+				std::vector<double> error(num_components);
+				std::vector<double> result = quad_panels_multi(
+						f, num_components, {r,cutoff}, epsabs, epsrel,
+						250, error.data());
+				std::vector<double> f_cutoff(num_components);
+				f(&cutoff, f_cutoff.data(), 1);
+				double tail = decay_tail(d, cutoff);
+
+				bool is_converged = true;
+				for(std::size_t c = 0; c < num_components; ++c){
+					is_converged = is_converged
+						&& std::abs(f_cutoff[c] * tail)
+						<= std::max(epsabs, epsrel * std::abs(result[c]));
+				}
+				if(!is_converged){
+					const double next_cutoff = decay_cutoff(d, cutoff, eps);
+					std::vector<double> residue_error(num_components);
+					const std::vector<double> residue = quad_panels_multi(
+							f, num_components, {cutoff,next_cutoff},
+							epsabs, epsrel, 250, residue_error.data());
+					for(std::size_t c = 0; c < num_components; ++c){
+						result[c] += residue[c];
+						error[c] += residue_error[c];
+					}
+					cutoff = next_cutoff;
+					f(&cutoff, f_cutoff.data(), 1);
+					tail = decay_tail(d, cutoff);
+				}
+
+				for(std::size_t c = 0; c < num_components; ++c){
+					result[c] += f_cutoff[c] * tail;
+					if(abserr != nullptr){
+						abserr[c] = error[c] + std::abs(f_cutoff[c] * tail);
+					}
+				}
+				return result;
+			}
+
+		template<typename F>
+			std::vector<double> int_0_inf_panels_multi(
+					F f,
+					const std::size_t num_components,
+					const decay &d,
+					const double epsabs = 1.49e-8,
+					const double epsrel = 1.49e-8,
+					double *abserr = nullptr)
+			{
+				return int_r_inf_panels_multi(f, num_components, 0., d,
+						epsabs, epsrel, abserr);
+			}
+
+	} /*namespace integration*/
+} /*namespace effz*/
+
+#endif /* EFFZ_GAUSS_KRONROD_H */
@@ -0,0 +1,1229 @@
+/*
+Copyright 2018 Oleg Skoromnik
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "effz_integral_database.h"
+
+#include "effz_config.h"
+#include "effz_exceptions.h"
+#include "effz_gauss_kronrod.h"
+#include "effz_parallel_func.h"
+#include "effz_radial_grid.h"
+#include "effz_zeroth_order.h"
+
+#include "cereal/types/vector.hpp"
+#include "cereal/types/array.hpp"
+#include "cereal/types/tuple.hpp"
+#include "cereal/archives/json.hpp"
+
+#include <array>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <exception>
+#include <fstream>
+#include <tuple>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace effz {
+	namespace zeroth_order {
+		namespace {
+
+			const std::size_t num_tiers = 3;
+
+			/*
+			 *one load of a shared database, reset_databases() starts
+			 *a new one by replacing the slot
+			 */
+			template<typename Database>
+				struct shared_slot{
+					std::once_flag is_loaded;
+					std::shared_ptr<const Database> db;
+				};
+
+			/*
+			 *process wide instances per precision tier, the mutex
+			 *guards the slots only, not the loading
+			 */
+			struct shared_databases{
+				std::mutex mutex;
+				std::array<std::shared_ptr<shared_slot<i_direct_database>>,
+					num_tiers> i_direct;
+				std::array<std::shared_ptr<
+					shared_slot<i_exchange_database>>, num_tiers> i_exchange;
+			};
+
+			std::size_t tier_index(const precision_tier tier)
+			{
+				return static_cast<std::size_t>(tier);
+			}
+
+			shared_databases& get_shared_databases()
+			{
+				static shared_databases instance;
+				return instance;
+			}
+
+			/*
+			 *Loads (or calculates) the database of current once. The
+			 *load runs outside the mutex and isolated: a thread that
+			 *waits for the parallel build can not pick up an outer task
+			 *(e.g. e_0th of a parallel loop over configurations) that
+			 *would call shared() again, and other callers wait on the
+			 *once_flag of this tier only.
+			 */
+			template<typename Database>
+				std::shared_ptr<const Database> load_shared(
+						std::shared_ptr<shared_slot<Database>> &current,
+						const precision_tier tier)
+				{
+					std::shared_ptr<shared_slot<Database>> slot;
+					{
+						shared_databases &dbs = get_shared_databases();
+						std::lock_guard<std::mutex> lock(dbs.mutex);
+						if(!current){
+							current = std::make_shared<
+								shared_slot<Database>>();
+						}
+						slot = current;
+					}
+					std::call_once(slot->is_loaded, [&slot, tier](){
+						slot->db = tbb::this_task_arena::isolate([tier](){
+							return std::make_shared<const Database>(
+									Database::default_path(tier),
+									precision_policy::preset(tier));
+							});
+						});
+					return slot->db;
+				}
+
+			struct binary_header{
+				char magic[8];
+				std::uint32_t version;
+				std::uint32_t byte_order;
+				std::uint32_t kind;
+				std::int32_t n_max;
+				std::int32_t k_max;
+				std::uint32_t reserved;
+				std::uint64_t num_dense;
+				std::uint64_t num_sparse;
+				std::uint64_t dense_offset;
+				std::uint64_t keys_offset;
+				std::uint64_t values_offset;
+			};
+
+			const char binary_magic[8] = {'E','F','F','Z','I','N','T','\0'};
+			const std::uint32_t binary_version = 1;
+			const std::uint32_t binary_byte_order = 0x01020304;
+
+			/*
+			 *orbital index n(n-1)/2 + l back to {n,l}
+			 */
+			std::array<int,2> orbital_nl(const int orbital)
+			{
+				int n = 1;
+				while((n + 1) * n / 2 <= orbital){ ++n; }
+				return {n, orbital - n * (n - 1) / 2};
+			}
+
+			bool is_readable(const std::string &path)
+			{
+				return std::ifstream(path).good();
+			}
+
+			/*
+			 *waits for the advisory lock of fd, false if it failed
+			 */
+			bool lock_file(const int fd)
+			{
+				while(::flock(fd, LOCK_EX) != 0){
+					if(errno != EINTR){
+						return false;
+					}
+				}
+				return true;
+			}
+
+			/*
+			 *whether fd is still the file at path, a merge may have
+			 *removed it while we waited for the lock
+			 */
+			bool is_linked(const int fd, const std::string &path)
+			{
+				struct stat opened;
+				struct stat linked;
+				return ::fstat(fd, &opened) == 0
+					&& ::stat(path.c_str(), &linked) == 0
+					&& opened.st_dev == linked.st_dev
+					&& opened.st_ino == linked.st_ino;
+			}
+
+			std::vector<integral_table::elem_t> load_json(
+					const std::string &path)
+			{
+				std::ifstream s(path);
+				if(!s.is_open()){
+					throw std::runtime_error("can not open " + path);
+				}
+				std::vector<integral_table::elem_t> database;
+				cereal::JSONInputArchive input(s);
+				input(CEREAL_NVP(database));
+				return database;
+			}
+
+			/*
+			 *written to <path>.tmp and renamed like the binary table,
+			 *an interrupted export leaves the previous file intact
+			 */
+			void save_json(const std::string &path,
+					const std::vector<integral_table::elem_t> &database)
+			{
+				const std::string tmp_path = path + ".tmp";
+				{
+					std::ofstream s(tmp_path,
+							std::ios::out | std::ios::trunc);
+					if(!s.is_open()){
+						throw std::runtime_error("can not open " + tmp_path);
+					}
+					{
+						cereal::JSONOutputArchive output(s);
+						output(CEREAL_NVP(database));
+					}
+					s.close();
+					if(!s){
+						throw std::runtime_error("can not write " + tmp_path);
+					}
+				}
+				if(std::rename(tmp_path.c_str(), path.c_str()) != 0){
+					throw std::system_error(errno, std::generic_category(),
+							"Error renaming " + tmp_path);
+				}
+			}
+
+			/*
+			 *fills table with the integrals of all keys and returns
+			 *the timing of every entry
+			 */
+			std::vector<build_timing> build_table(
+					const integral_kind kind,
+					const std::vector<std::array<int,5>> &keys,
+					const precision_policy &precision,
+					integral_table &table)
+			{
+				std::vector<build_timing> timings;
+				const std::vector<double> values =
+					calculate_integrals(kind, keys, precision, &timings);
+				for(std::size_t i = 0; i < values.size(); ++i){
+					table.insert(keys[i], values[i]);
+				}
+				return timings;
+			}
+
+			/*
+			 *keys sharing one y_k potential on the grid: (n1,l1,k) for
+			 *direct, the unordered pair of orbitals and k for exchange
+			 */
+			std::uint64_t potential_key(
+					const integral_kind kind,
+					const std::array<int,5> &key)
+			{
+				if(kind == integral_kind::direct){
+					return integral_table::pack(0,0,key[2],key[3],key[4]);
+				}
+				const bool is_ordered = key[0] * (key[0] - 1) / 2 + key[1]
+					<= key[2] * (key[2] - 1) / 2 + key[3];
+				return is_ordered
+					? integral_table::pack(key[0],key[1],key[2],key[3],key[4])
+					: integral_table::pack(key[2],key[3],key[0],key[1],key[4]);
+			}
+
+			/*
+			 *fast tier: one task per potential, contracted with all
+			 *outer densities of its keys by the radial grid tables
+			 */
+			std::vector<double> calculate_grid_integrals(
+					const integral_kind kind,
+					const std::vector<std::array<int,5>> &keys,
+					const precision_policy &precision,
+					std::vector<double> &seconds)
+			{
+				int n_max = 7;
+				std::unordered_map<std::uint64_t, std::size_t> group_index;
+				std::vector<std::vector<std::size_t>> groups;
+				for(std::size_t i = 0; i < keys.size(); ++i){
+					n_max = std::max(n_max, std::max(keys[i][0], keys[i][2]));
+					const auto it = group_index.emplace(
+							potential_key(kind, keys[i]), groups.size()).first;
+					if(it->second == groups.size()){
+						groups.emplace_back();
+					}
+					groups[it->second].push_back(i);
+				}
+
+				/*
+				 *the grid of fast_orbitals in i_direct/i_exchange for
+				 *n <= 7, so table entries and computed misses agree
+				 */
+				const effz::radial::orbital_table orbitals(
+						effz::radial::radial_grid::for_n_max(n_max,
+							precision.grid_step),
+						n_max);
+				std::vector<double> group_seconds;
+				const std::vector<std::vector<double>> group_values =
+					effz::parallel::parallel_map_by_cost(groups,
+							[kind, &keys, &orbitals](
+								const std::vector<std::size_t> &group){
+								std::vector<std::array<int,5>> group_keys;
+								for(const std::size_t i: group){
+									group_keys.push_back(keys[i]);
+								}
+								return kind == integral_kind::direct
+									? effz::radial::grid_direct_table(
+											orbitals, group_keys)
+									: effz::radial::grid_exchange_table(
+											orbitals, group_keys);
+							},
+							[](const std::vector<std::size_t> &group){
+								return static_cast<double>(group.size());
+							},
+							&group_seconds);
+
+				std::vector<double> values(keys.size());
+				seconds.assign(keys.size(), 0.);
+				for(std::size_t g = 0; g < groups.size(); ++g){
+					for(std::size_t j = 0; j < groups[g].size(); ++j){
+						values[groups[g][j]] = group_values[g][j];
+						seconds[groups[g][j]] = group_seconds[g]
+							/ static_cast<double>(groups[g].size());
+					}
+				}
+				return values;
+			}
+
+		} /* end anonymous namespace */
+
+		std::vector<double> calculate_integrals(
+				const integral_kind kind,
+				const std::vector<std::array<int,5>> &keys,
+				const precision_policy &precision,
+				std::vector<build_timing> *timings)
+		{
+			auto cost = [kind, &precision](const std::array<int,5> &key){
+				return estimated_cost(kind, key, precision);
+			};
+			std::vector<double> seconds;
+			std::vector<double> values;
+			if(precision.tier == precision_tier::fast){
+				values = calculate_grid_integrals(kind, keys, precision,
+						seconds);
+			} else {
+				values = effz::parallel::parallel_map_by_cost(keys,
+						[kind, &precision](const std::array<int,5> &key){
+							return kind == integral_kind::direct
+								? i_direct(key[0],key[1],key[2],key[3],key[4],
+										precision)
+								: i_exchange(key[0],key[1],key[2],key[3],
+										key[4], precision);
+						},
+						cost, &seconds);
+			}
+			if(timings != nullptr){
+				timings->clear();
+				timings->reserve(keys.size());
+				for(std::size_t i = 0; i < keys.size(); ++i){
+					timings->push_back({keys[i], cost(keys[i]), seconds[i]});
+				}
+			}
+			return values;
+		}
+
+		double estimated_cost(
+				const integral_kind kind,
+				const std::array<int,5> &key,
+				const precision_policy &precision)
+		{
+			const int n = key[0];
+			const int l = key[1];
+			const int n1 = key[2];
+			const int l1 = key[3];
+			const int k = key[4];
+			if(precision.tier == precision_tier::fast){
+				return 1.;
+			}
+			/*
+			 *R_nl has n-l terms
+			 */
+			const double terms = kind == integral_kind::direct
+				? (2. * (n - l) - 1.) * (2. * (n1 - l1) - 1.)
+				: std::pow((n - l) + (n1 - l1) - 1., 2);
+			double cost = terms * (n + n1 + k);
+			if(precision.tier == precision_tier::reference){
+				const effz::integration::decay d =
+					kind == integral_kind::direct
+					? effz::integration::decay{2. / std::max(n,n1),
+						2. * (std::max(n,n1) - 1)}
+					: effz::integration::decay{1. / n + 1. / n1,
+						n + n1 - 2.};
+				const double length = d.alpha
+					* effz::integration::decay_cutoff(d, 0.,
+							precision.epsrel);
+				cost += 441. * length * length;
+			}
+			return cost;
+		}
+
+		/*
+		 *read only mapping of a whole file
+		 */
+		struct integral_table::mapped_file{
+			void *data;
+			std::size_t size;
+
+			explicit mapped_file(const std::string &path)
+				: data(MAP_FAILED), size(0)
+			{
+				const int fd = ::open(path.c_str(), O_RDONLY);
+				if(fd < 0){
+					throw std::system_error(errno, std::generic_category(),
+							"Error opening " + path);
+				}
+				struct stat info;
+				if(::fstat(fd, &info) != 0){
+					const int err = errno;
+					::close(fd);
+					throw std::system_error(err, std::generic_category(),
+							"Error checking " + path);
+				}
+				size = static_cast<std::size_t>(info.st_size);
+				if(size > 0){
+					data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED,
+							fd, 0);
+				}
+				const int err = errno;
+				::close(fd);
+				if(data == MAP_FAILED){
+					throw std::system_error(err, std::generic_category(),
+							"Error mapping " + path);
+				}
+			}
+
+			~mapped_file()
+			{
+				if(data != MAP_FAILED){
+					::munmap(data, size);
+				}
+			}
+
+			mapped_file(const mapped_file&) = delete;
+			void operator=(const mapped_file&) = delete;
+		};
+
+		integral_table::integral_table(const int n_max, const int k_max)
+			: n_max(n_max), k_max(k_max),
+			num_orbitals(n_max * (n_max + 1) / 2),
+			num_dense(static_cast<std::size_t>(num_orbitals)
+					* static_cast<std::size_t>(num_orbitals)
+					* static_cast<std::size_t>(k_max + 1)),
+			dense(num_dense, std::numeric_limits<double>::quiet_NaN()),
+			overflow(), mapping(), mapped_dense(nullptr),
+			mapped_keys(nullptr), mapped_values(nullptr),
+			num_mapped_sparse(0) {}
+
+		std::uint64_t integral_table::pack(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k)
+		{
+			auto field = [](const int x) -> std::uint64_t {
+				if(x < 0 || x > 0xfff){
+					throw std::out_of_range(
+							"integral_table: quantum number outside [0, 4095]");
+				}
+				return static_cast<std::uint64_t>(x);
+			};
+			return field(n) << 48 | field(l) << 36 | field(n1) << 24
+				| field(l1) << 12 | field(k);
+		}
+
+		std::array<int,5> integral_table::unpack(const std::uint64_t key)
+		{
+			auto field = [key](const int shift) -> int {
+				return static_cast<int>((key >> shift) & 0xfffu);
+			};
+			return {field(48), field(36), field(24), field(12), field(0)};
+		}
+
+		const double* integral_table::dense_values() const
+		{
+			return mapping ? mapped_dense : dense.data();
+		}
+
+		bool integral_table::is_dense(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k) const
+		{
+			return n >= 1 && n <= n_max && l >= 0 && l < n
+				&& n1 >= 1 && n1 <= n_max && l1 >= 0 && l1 < n1
+				&& k >= 0 && k <= k_max;
+		}
+
+		std::size_t integral_table::dense_index(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k) const
+		{
+			const int orbital = n * (n - 1) / 2 + l;
+			const int orbital1 = n1 * (n1 - 1) / 2 + l1;
+			return (static_cast<std::size_t>(orbital * num_orbitals
+						+ orbital1)) * static_cast<std::size_t>(k_max + 1)
+				+ static_cast<std::size_t>(k);
+		}
+
+		void integral_table::insert(const std::array<int,5> &key,
+				const double value)
+		{
+			const int n = key[0], l = key[1], n1 = key[2], l1 = key[3],
+				  k = key[4];
+			if(!mapping && is_dense(n,l,n1,l1,k)){
+				dense[dense_index(n,l,n1,l1,k)] = value;
+			} else {
+				overflow[pack(n,l,n1,l1,k)] = value;
+			}
+		}
+
+		bool integral_table::find(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k,
+				double &value) const
+		{
+			if(is_dense(n,l,n1,l1,k)){
+				value = dense_values()[dense_index(n,l,n1,l1,k)];
+				if(!std::isnan(value)){
+					return true;
+				}
+				if(!mapping){
+					return false;
+				}
+			}
+			const std::uint64_t key = pack(n,l,n1,l1,k);
+			const auto it = overflow.find(key);
+			if(it != overflow.cend()){
+				value = it->second;
+				return true;
+			}
+			if(num_mapped_sparse != 0){
+				const std::uint64_t *end = mapped_keys + num_mapped_sparse;
+				const std::uint64_t *pos =
+					std::lower_bound(mapped_keys, end, key);
+				if(pos != end && *pos == key){
+					value = mapped_values[pos - mapped_keys];
+					return true;
+				}
+			}
+			return false;
+		}
+
+		std::vector<integral_table::elem_t> integral_table::entries() const
+		{
+			std::vector<elem_t> res;
+			const double *values = dense_values();
+			for(int orbital = 0; orbital < num_orbitals; ++orbital){
+				const std::array<int,2> nl = orbital_nl(orbital);
+				for(int orbital1 = 0; orbital1 < num_orbitals; ++orbital1){
+					const std::array<int,2> nl1 = orbital_nl(orbital1);
+					for(int k = 0; k <= k_max; ++k){
+						const double value = values[dense_index(
+								nl[0], nl[1], nl1[0], nl1[1], k)];
+						const std::uint64_t key =
+							pack(nl[0], nl[1], nl1[0], nl1[1], k);
+						if(!std::isnan(value) && !overflow.count(key)){
+							res.emplace_back(unpack(key), value);
+						}
+					}
+				}
+			}
+			for(std::size_t i = 0; i < num_mapped_sparse; ++i){
+				if(!overflow.count(mapped_keys[i])){
+					res.emplace_back(unpack(mapped_keys[i]),
+							mapped_values[i]);
+				}
+			}
+			for(const auto &el: overflow){
+				res.emplace_back(unpack(el.first), el.second);
+			}
+			return res;
+		}
+
+		std::size_t integral_table::size() const
+		{
+			const double *values = dense_values();
+			std::size_t res = overflow.size() + num_mapped_sparse;
+			for(std::size_t i = 0; i < num_dense; ++i){
+				if(!std::isnan(values[i])){
+					++res;
+				}
+			}
+			/*
+			 *entries inserted into a mapped table shadow the mapped
+			 *ones with the same key
+			 */
+			const std::uint64_t *end = mapped_keys + num_mapped_sparse;
+			for(const auto &el: overflow){
+				const std::array<int,5> key = unpack(el.first);
+				if(is_dense(key[0],key[1],key[2],key[3],key[4])){
+					if(!std::isnan(values[dense_index(
+									key[0],key[1],key[2],key[3],key[4])])){
+						--res;
+					}
+				} else if(num_mapped_sparse != 0
+						&& std::binary_search(mapped_keys, end, el.first)){
+					--res;
+				}
+			}
+			return res;
+		}
+
+		void integral_table::save_binary(const std::string &path,
+				const integral_kind kind) const
+		{
+			/*
+			 *flatten into a fresh table so every dense key is in the
+			 *dense block and the rest is sorted
+			 */
+			integral_table flat(n_max, k_max);
+			for(const auto &el: entries()){
+				flat.insert(std::get<0>(el), std::get<1>(el));
+			}
+			std::vector<std::pair<std::uint64_t,double>> sparse(
+					flat.overflow.cbegin(), flat.overflow.cend());
+			std::sort(sparse.begin(), sparse.end());
+			std::vector<std::uint64_t> keys;
+			std::vector<double> values;
+			for(const auto &el: sparse){
+				keys.push_back(el.first);
+				values.push_back(el.second);
+			}
+
+			binary_header header;
+			std::memset(&header, 0, sizeof(header));
+			std::memcpy(header.magic, binary_magic, sizeof(binary_magic));
+			header.version = binary_version;
+			header.byte_order = binary_byte_order;
+			header.kind = static_cast<std::uint32_t>(kind);
+			header.n_max = n_max;
+			header.k_max = k_max;
+			header.num_dense = flat.num_dense;
+			header.num_sparse = keys.size();
+			header.dense_offset = sizeof(binary_header);
+			header.keys_offset = header.dense_offset
+				+ header.num_dense * sizeof(double);
+			header.values_offset = header.keys_offset
+				+ header.num_sparse * sizeof(std::uint64_t);
+
+			/*
+			 *written next to the target and renamed, so readers never
+			 *see a partial file
+			 */
+			const std::string tmp_path = path + ".tmp";
+			{
+				std::ofstream s(tmp_path, std::ios::out
+						| std::ios::binary | std::ios::trunc);
+				if(!s.is_open()){
+					throw std::runtime_error("can not open " + tmp_path);
+				}
+				s.write(reinterpret_cast<const char*>(&header),
+						sizeof(header));
+				s.write(reinterpret_cast<const char*>(flat.dense.data()),
+						flat.dense.size() * sizeof(double));
+				s.write(reinterpret_cast<const char*>(keys.data()),
+						keys.size() * sizeof(std::uint64_t));
+				s.write(reinterpret_cast<const char*>(values.data()),
+						values.size() * sizeof(double));
+				s.close();
+				if(!s){
+					throw std::runtime_error("can not write " + tmp_path);
+				}
+			}
+			if(std::rename(tmp_path.c_str(), path.c_str()) != 0){
+				throw std::system_error(errno, std::generic_category(),
+						"Error renaming " + tmp_path);
+			}
+		}
+
+		void integral_table::export_json(const std::string &path) const
+		{
+			save_json(path, entries());
+		}
+
+		integral_table integral_table::map_binary(const std::string &path,
+				const integral_kind kind)
+		{
+			auto file = std::make_shared<const mapped_file>(path);
+			binary_header header;
+			if(file->size < sizeof(header)){
+				throw parsing_exception("integral table: truncated header");
+			}
+			std::memcpy(&header, file->data, sizeof(header));
+			if(std::memcmp(header.magic, binary_magic,
+						sizeof(binary_magic)) != 0
+					|| header.version != binary_version
+					|| header.byte_order != binary_byte_order
+					|| header.kind != static_cast<std::uint32_t>(kind)){
+				throw parsing_exception(
+						"integral table: not a compatible binary table");
+			}
+			if(header.n_max < 1 || header.k_max < 0){
+				throw parsing_exception("integral table: bad dimensions");
+			}
+
+			integral_table table(0, header.k_max);
+			table.n_max = header.n_max;
+			table.num_orbitals = header.n_max * (header.n_max + 1) / 2;
+			table.num_dense = static_cast<std::size_t>(table.num_orbitals)
+				* static_cast<std::size_t>(table.num_orbitals)
+				* static_cast<std::size_t>(table.k_max + 1);
+			const std::uint64_t end = header.values_offset
+				+ header.num_sparse * sizeof(double);
+			if(header.num_dense != table.num_dense
+					|| header.dense_offset % sizeof(double) != 0
+					|| header.keys_offset != header.dense_offset
+					+ header.num_dense * sizeof(double)
+					|| header.values_offset != header.keys_offset
+					+ header.num_sparse * sizeof(std::uint64_t)
+					|| end > file->size){
+				throw parsing_exception("integral table: bad layout");
+			}
+			const char *base = static_cast<const char*>(file->data);
+			table.mapped_dense = reinterpret_cast<const double*>(
+					base + header.dense_offset);
+			table.mapped_keys = reinterpret_cast<const std::uint64_t*>(
+					base + header.keys_offset);
+			table.mapped_values = reinterpret_cast<const double*>(
+					base + header.values_offset);
+			table.num_mapped_sparse =
+				static_cast<std::size_t>(header.num_sparse);
+			table.mapping = file;
+			return table;
+		}
+
+		integral_journal::integral_journal(const std::string &path)
+			: path(path), mutex(), values(), file_mutex(),
+			is_writable(true) {}
+
+		std::size_t integral_journal::replay(integral_table &table) const
+		{
+			std::ifstream s(path, std::ios::in | std::ios::binary);
+			if(!s.is_open()){
+				return 0;
+			}
+			/*
+			 *a record cut short by a crash is ignored
+			 */
+			std::size_t num_records = 0;
+			std::uint64_t key;
+			double value;
+			while(s.read(reinterpret_cast<char*>(&key), sizeof(key))
+					&& s.read(reinterpret_cast<char*>(&value), sizeof(value))){
+				table.insert(integral_table::unpack(key), value);
+				++num_records;
+			}
+			return num_records;
+		}
+
+		std::size_t integral_journal::merge(integral_table &table,
+				const std::function<bool(std::size_t)> &publish)
+		{
+			std::lock_guard<std::mutex> file_lock(file_mutex);
+			const int fd = ::open(path.c_str(), O_RDONLY);
+			if(fd < 0 || !lock_file(fd) || !is_linked(fd, path)){
+				if(fd >= 0){
+					::close(fd);
+				}
+				publish(0);
+				return 0;
+			}
+			std::size_t num_records = 0;
+			try{
+				num_records = replay(table);
+				/*
+				 *records left behind are published already and just
+				 *merged again on the next load
+				 */
+				if(publish(num_records) && ::unlink(path.c_str()) != 0){
+					std::cerr << "can not remove " << path << ": "
+						<< std::strerror(errno) << "\n";
+				}
+			} catch (...){
+				::close(fd);
+				throw;
+			}
+			::close(fd);
+			return num_records;
+		}
+
+		void integral_journal::clear()
+		{
+			std::lock_guard<std::mutex> file_lock(file_mutex);
+			if(std::remove(path.c_str()) != 0 && errno != ENOENT){
+				throw std::system_error(errno, std::generic_category(),
+						"Error removing " + path);
+			}
+		}
+
+		bool integral_journal::find(const std::uint64_t key,
+				double &value) const
+		{
+			std::shared_lock<std::shared_timed_mutex> lock(mutex);
+			const auto it = values.find(key);
+			if(it == values.cend()){
+				return false;
+			}
+			value = it->second;
+			return true;
+		}
+
+		void integral_journal::append(const std::uint64_t key,
+				const double value)
+		{
+			append({{key, value}});
+		}
+
+		void integral_journal::append(
+				const std::vector<std::pair<std::uint64_t,double>> &records)
+		{
+			const std::size_t record_size =
+				sizeof(std::uint64_t) + sizeof(double);
+			std::vector<char> buffer;
+			{
+				std::lock_guard<std::shared_timed_mutex> lock(mutex);
+				buffer.reserve(records.size() * record_size);
+				for(const auto &record: records){
+					if(!values.emplace(record.first, record.second).second){
+						continue;
+					}
+					const std::size_t offset = buffer.size();
+					buffer.resize(offset + record_size);
+					std::memcpy(buffer.data() + offset, &record.first,
+							sizeof(std::uint64_t));
+					std::memcpy(buffer.data() + offset
+							+ sizeof(std::uint64_t),
+							&record.second, sizeof(double));
+				}
+			}
+			/*
+			 *the file is written without blocking find()
+			 */
+			std::lock_guard<std::mutex> file_lock(file_mutex);
+			if(buffer.empty() || !is_writable){
+				return;
+			}
+			/*
+			 *one O_APPEND write per call, so concurrent processes
+			 *do not interleave, and fsync before returning. The file
+			 *is opened again if a merge removed it before it was
+			 *locked.
+			 */
+			int fd = ::open(path.c_str(),
+					O_WRONLY | O_APPEND | O_CREAT, 0644);
+			bool is_locked = fd >= 0 && lock_file(fd);
+			while(is_locked && !is_linked(fd, path)){
+				::close(fd);
+				fd = ::open(path.c_str(),
+						O_WRONLY | O_APPEND | O_CREAT, 0644);
+				is_locked = fd >= 0 && lock_file(fd);
+			}
+			bool is_written = is_locked
+				&& ::write(fd, buffer.data(), buffer.size())
+				== static_cast<ssize_t>(buffer.size())
+				&& ::fsync(fd) == 0;
+			const int err = errno;
+			if(fd >= 0){
+				is_written = (::close(fd) == 0) && is_written;
+			}
+			if(!is_written){
+				is_writable = false;
+				std::cerr << "can not append to " << path << ": "
+					<< std::strerror(err) << ", further misses are kept"
+					<< " in memory only\n";
+			}
+		}
+
+		void i_direct_database::calculate_database()
+		{
+			std::vector<std::array<int,5>> direct_quantum_nums;
+			for(int n = 1; n <= 6; ++n){
+				for(int l = 0; l <= n - 1; ++l){
+					for(int n1 = 1; n1 <= 6; ++n1){
+						for(int l1 = 0; l1 <= n1 - 1; ++l1){
+							for(int k = 0; k <= std::min(l,l1); ++k){
+								direct_quantum_nums
+									.push_back({n,l,n1,l1,2*k});
+							}
+						}
+					}
+				}
+			}
+
+			for(int n = 1; n <= 6; ++n){
+				for(int l = 0; l <= n - 1; ++l){
+					for(int l1 = 0; l1 <= 2; ++l1){
+						for(int k = 0; k <= std::min(l,l1); ++k){
+							direct_quantum_nums
+								.push_back({n,l,7,l1,2*k});
+						}
+					}
+				}
+			}
+
+			for(int n1 = 1; n1 <= 6; ++n1){
+				for(int l1 = 0; l1 <= n1 - 1; ++l1){
+					for(int l = 0; l <= 2; ++l){
+						for(int k = 0; k <= std::min(l,l1); ++k){
+							direct_quantum_nums
+								.push_back({7,l,n1,l1,2*k});
+						}
+					}
+				}
+			}
+
+			for(int l = 0; l <= 2; ++l){
+				for(int l1 = 0; l1 <= 2; ++l1){
+					for(int k = 0; k <= std::min(l,l1); ++k){
+						direct_quantum_nums.push_back({7,l,7,l1,2*k});
+					}
+				}
+			}
+
+			build_timings = build_table(integral_kind::direct,
+					direct_quantum_nums, precision, table);
+		}
+
+		i_direct_database::i_direct_database(
+				const std::string &path_to_data,
+				const precision_policy &precision)
+			: path_to_data(path_to_data), precision(precision), table(),
+			journal(path_to_data + ".journal"), build_timings()
+		{
+			const std::string binary_path = path_to_data + ".bin";
+			const std::string json_path = path_to_data + ".txt";
+			bool is_mapped = false;
+			try{
+				if(is_readable(binary_path)){
+					table = integral_table::map_binary(binary_path,
+							integral_kind::direct);
+					is_mapped = true;
+				}
+			} catch (const std::exception &e){
+				std::cerr << "can not map " << binary_path << ": "
+					<< e.what() << "\n";
+			}
+			if(!is_mapped){
+				try{
+					if(is_readable(json_path)){
+						import_json(json_path);
+					} else {
+						calculate_database();
+						export_json(json_path);
+					}
+				} catch (const std::exception &e){
+					std::cerr << "error happened " << e.what();
+					throw;
+				}
+			}
+			/*
+			 *the journal is removed only once the table with its
+			 *records is published
+			 */
+			journal.merge(table, [this, is_mapped, &binary_path](
+						const std::size_t num_replayed){
+					if(is_mapped && num_replayed == 0){
+						return false;
+					}
+					try{
+						table.save_binary(binary_path, integral_kind::direct);
+						return true;
+					} catch (const std::exception &e){
+						std::cerr << "can not save " << binary_path << ": "
+							<< e.what() << "\n";
+					}
+					return false;
+					});
+		}
+
+		std::string i_direct_database::default_path(
+				const precision_tier tier)
+		{
+			return config::shared_config().get_database_dir()
+				+ "/i_direct_database"
+				+ precision_policy::preset(tier).database_suffix();
+		}
+
+		double i_direct_database::get_i_direct(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k) const
+		{
+			double value;
+			if(table.find(n,l,n1,l1,k,value)){
+				return value;
+			}
+			const std::uint64_t key = integral_table::pack(n,l,n1,l1,k);
+			if(journal.find(key, value)){
+				return value;
+			}
+			value = i_direct(n,l,n1,l1,k,precision);
+			journal.append(key, value);
+			return value;
+		}
+
+		const std::vector<build_timing>&
+			i_direct_database::get_build_timings() const
+		{
+			return build_timings;
+		}
+
+		void i_direct_database::import_json(const std::string &path)
+		{
+			for(const auto &el: load_json(path)){
+				table.insert(std::get<0>(el), std::get<1>(el));
+			}
+		}
+
+		void i_direct_database::export_json(const std::string &path) const
+		{
+			table.export_json(path);
+		}
+
+		void i_exchange_database::calculate_database()
+		{
+			std::vector<std::array<int,5>> exchange_quantum_nums;
+			for(int n = 1; n <= 6; ++n){
+				for(int l = 0; l <= n - 1; ++l){
+					for(int n1 = 1; n1 <= 6; ++n1){
+						for(int l1 = 0; l1 <= n1 - 1; ++l1){
+							for(int k = std::abs(l-l1); k <= l+l1; ++k){
+								exchange_quantum_nums
+									.push_back({n,l,n1,l1,k});
+							}
+						}
+					}
+				}
+			}
+
+			for(int n = 1; n <= 6; ++n){
+				for(int l = 0; l <= n - 1; ++l){
+					for(int l1 = 0; l1 <= 1; ++l1){
+						for(int k = std::abs(l-l1); k <= l+l1; ++k){
+							exchange_quantum_nums
+								.push_back({n,l,7,l1,k});
+						}
+					}
+				}
+			}
+
+			for(int n1 = 1; n1 <= 6; ++n1){
+				for(int l1 = 0; l1 <= n1 - 1; ++l1){
+					for(int l = 0; l <= 1; ++l){
+						for(int k = std::abs(l-l1); k <= l+l1; ++k){
+							exchange_quantum_nums
+								.push_back({7,l,n1,l1,k});
+						}
+					}
+				}
+			}
+
+			for(int l = 0; l <= 1; ++l){
+				for(int l1 = 0; l1 <= 1; ++l1){
+					for(int k = std::abs(l-l1); k <= l+l1; ++k){
+						exchange_quantum_nums.push_back({7,l,7,l1,k});
+					}
+				}
+			}
+
+			build_timings = build_table(integral_kind::exchange,
+					exchange_quantum_nums, precision, table);
+		}
+
+		i_exchange_database::i_exchange_database(
+				const std::string &path_to_data,
+				const precision_policy &precision)
+			: path_to_data(path_to_data), precision(precision), table(),
+			journal(path_to_data + ".journal"), build_timings()
+		{
+			const std::string binary_path = path_to_data + ".bin";
+			const std::string json_path = path_to_data + ".txt";
+			bool is_mapped = false;
+			try{
+				if(is_readable(binary_path)){
+					table = integral_table::map_binary(binary_path,
+							integral_kind::exchange);
+					is_mapped = true;
+				}
+			} catch (const std::exception &e){
+				std::cerr << "can not map " << binary_path << ": "
+					<< e.what() << "\n";
+			}
+			if(!is_mapped){
+				try{
+					if(is_readable(json_path)){
+						import_json(json_path);
+					} else {
+						calculate_database();
+						export_json(json_path);
+					}
+				} catch (const std::exception &e){
+					std::cerr << "error happened " << e.what();
+					throw;
+				}
+			}
+			/*
+			 *the journal is removed only once the table with its
+			 *records is published
+			 */
+			journal.merge(table, [this, is_mapped, &binary_path](
+						const std::size_t num_replayed){
+					if(is_mapped && num_replayed == 0){
+						return false;
+					}
+					try{
+						table.save_binary(binary_path, integral_kind::exchange);
+						return true;
+					} catch (const std::exception &e){
+						std::cerr << "can not save " << binary_path << ": "
+							<< e.what() << "\n";
+					}
+					return false;
+					});
+		}
+
+		std::string i_exchange_database::default_path(
+				const precision_tier tier)
+		{
+			return config::shared_config().get_database_dir()
+				+ "/i_exchange_database"
+				+ precision_policy::preset(tier).database_suffix();
+		}
+
+		double i_exchange_database::get_i_exchange(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k) const
+		{
+			double value;
+			if(table.find(n,l,n1,l1,k,value)){
+				return value;
+			}
+			const std::uint64_t key = integral_table::pack(n,l,n1,l1,k);
+			if(journal.find(key, value)){
+				return value;
+			}
+			value = i_exchange(n,l,n1,l1,k,precision);
+			journal.append(key, value);
+			return value;
+		}
+
+		const std::vector<build_timing>&
+			i_exchange_database::get_build_timings() const
+		{
+			return build_timings;
+		}
+
+		void i_exchange_database::import_json(const std::string &path)
+		{
+			for(const auto &el: load_json(path)){
+				table.insert(std::get<0>(el), std::get<1>(el));
+			}
+		}
+
+		void i_exchange_database::export_json(const std::string &path) const
+		{
+			table.export_json(path);
+		}
+
+		std::shared_ptr<const i_direct_database> i_direct_database::shared(
+				const precision_tier tier)
+		{
+			return load_shared(
+					get_shared_databases().i_direct[tier_index(tier)], tier);
+		}
+
+		std::shared_ptr<const i_exchange_database>
+			i_exchange_database::shared(const precision_tier tier)
+			{
+				return load_shared(
+						get_shared_databases().i_exchange[tier_index(tier)],
+						tier);
+			}
+
+		void preload_databases(const precision_tier tier)
+		{
+			i_direct_database::shared(tier);
+			i_exchange_database::shared(tier);
+		}
+
+		void reset_databases()
+		{
+			shared_databases &dbs = get_shared_databases();
+			std::lock_guard<std::mutex> lock(dbs.mutex);
+			for(std::size_t i = 0; i < num_tiers; ++i){
+				dbs.i_direct[i].reset();
+				dbs.i_exchange[i].reset();
+			}
+		}
+
+	} /* end namespace zeroth_order */
+} /* end namespace effz */
+
+void effz_preload_databases()
+{
+	effz::zeroth_order::preload_databases();
+}
+
+void effz_reset_databases()
+{
+	effz::zeroth_order::reset_databases();
+}
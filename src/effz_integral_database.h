@@ -0,0 +1,333 @@
+/*
+Copyright 2018 Oleg Skoromnik
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef EFFZ_INTEGRAL_DATABASE_H
+#define EFFZ_INTEGRAL_DATABASE_H
+
+#ifdef __cplusplus
+#include "effz_precision.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace effz{
+	namespace zeroth_order{
+		/*
+		 *Radial integrals indexed by {n,l,n1,l1,k}. Keys with
+		 *n, n1 <= n_max and k <= k_max live in a dense array addressed
+		 *directly by the quantum numbers, everything else goes to a
+		 *hash map on the packed key. Lookups are O(1) either way.
+		 *
+		 *Binary file layout (native byte order, version 1):
+		 *    binary_header
+		 *    double dense[num_dense]           NaN marks a missing entry
+		 *    uint64 keys[num_sparse]           packed, sorted
+		 *    double values[num_sparse]
+		 *map_binary() uses the mapped file in place, so loading does no
+		 *parsing and no allocation, and all processes share the page
+		 *cache copy. Entries inserted into a mapped table are kept in
+		 *memory only.
+		 */
+		enum class integral_kind : std::uint32_t {direct = 1, exchange = 2};
+
+		class integral_table
+		{
+			public:
+				typedef std::tuple<std::array<int,5>,double> elem_t;
+
+				integral_table(const int n_max = 7, const int k_max = 12);
+
+				/*
+				 *12 bits per quantum number, throws std::out_of_range
+				 *for values outside [0, 4095]
+				 */
+				static std::uint64_t pack(
+						const int n,
+						const int l,
+						const int n1,
+						const int l1,
+						const int k);
+				static std::array<int,5> unpack(const std::uint64_t key);
+
+				void insert(const std::array<int,5> &key,
+						const double value);
+
+				bool find(
+						const int n,
+						const int l,
+						const int n1,
+						const int l1,
+						const int k,
+						double &value) const;
+
+				std::size_t size() const;
+				std::vector<elem_t> entries() const;
+
+				void save_binary(const std::string &path,
+						const integral_kind kind) const;
+				static integral_table map_binary(const std::string &path,
+						const integral_kind kind);
+
+				/*
+				 *all entries as the cereal JSON of the databases
+				 */
+				void export_json(const std::string &path) const;
+
+			private:
+				struct mapped_file;
+
+				int n_max;
+				int k_max;
+				int num_orbitals;
+				std::size_t num_dense;
+				std::vector<double> dense;
+				std::unordered_map<std::uint64_t, double> overflow;
+
+				std::shared_ptr<const mapped_file> mapping;
+				const double *mapped_dense;
+				const std::uint64_t *mapped_keys;
+				const double *mapped_values;
+				std::size_t num_mapped_sparse;
+
+				const double* dense_values() const;
+				bool is_dense(
+						const int n,
+						const int l,
+						const int n1,
+						const int l1,
+						const int k) const;
+				std::size_t dense_index(
+						const int n,
+						const int l,
+						const int n1,
+						const int l1,
+						const int k) const;
+		};
+
+		/*
+		 *Integrals that were missing from a table, computed on demand.
+		 *Each one is kept in memory and appended to the file at path
+		 *as a (packed key, double) record, so it survives the process.
+		 *replay() merges the records into a table at load time.
+		 *find() and append() are thread safe, find() takes a shared
+		 *lock only, appending a batch costs one write and one fsync.
+		 *
+		 *Appends hold an advisory lock (flock) on the file. merge()
+		 *replays it and calls publish(number of records) under that
+		 *lock, and removes the file only if publish returns true, so
+		 *records appended by other processes meanwhile are not lost.
+		 */
+		class integral_journal
+		{
+			public:
+				explicit integral_journal(const std::string &path);
+
+				std::size_t replay(integral_table &table) const;
+				std::size_t merge(integral_table &table,
+						const std::function<bool(std::size_t)> &publish);
+				void clear();
+
+				bool find(const std::uint64_t key, double &value) const;
+				void append(const std::uint64_t key, const double value);
+				void append(const std::vector<
+						std::pair<std::uint64_t,double>> &records);
+
+			private:
+				std::string path;
+				mutable std::shared_timed_mutex mutex;
+				std::unordered_map<std::uint64_t, double> values;
+				std::mutex file_mutex;
+				bool is_writable;
+		};
+
+		/*
+		 *relative cost of computing the integral {n,l,n1,l1,k} with
+		 *the given policy. The closed forms scale with the number of
+		 *polynomial terms of the orbital products times the order of
+		 *the incomplete gamma sums, quadrature (reference tier) with
+		 *the square of the decay cutoff in units of the decay length.
+		 *Only the ordering matters, build_timing gives the measured
+		 *values to compare against.
+		 */
+		double estimated_cost(
+				const integral_kind kind,
+				const std::array<int,5> &key,
+				const precision_policy &precision);
+
+		/*
+		 *one entry of a table calculated by calculate_database
+		 */
+		struct build_timing{
+			std::array<int,5> key;
+			double estimated_cost;
+			double seconds;
+		};
+
+		/*
+		 *i_direct or i_exchange with the given policy for all keys,
+		 *in parallel and longest job first by estimated_cost. On the
+		 *fast tier the keys sharing a y_k potential form one task
+		 *that builds it once (radial::grid_direct_table and
+		 *grid_exchange_table), the time of such a task is split
+		 *evenly over its keys. timings (if not null) receives one
+		 *entry per key.
+		 */
+		std::vector<double> calculate_integrals(
+				const integral_kind kind,
+				const std::vector<std::array<int,5>> &keys,
+				const precision_policy &precision,
+				std::vector<build_timing> *timings = nullptr);
+
+		/*
+		 *Tables of i_direct and i_exchange stored in
+		 *config::get_database_dir() as <path_to_data>.bin, with the
+		 *cereal JSON <path_to_data>.txt kept as import/export format.
+		 *The binary file is memory mapped if present, otherwise the JSON
+		 *file is imported, and if neither exists the table is calculated.
+		 *Both files are written in the last two cases.
+		 *
+		 *Lookups missing from the table are computed once and recorded
+		 *in <path_to_data>.journal. On the next load the journal is
+		 *merged into the table, the binary file is rewritten and the
+		 *journal removed, so repeated workloads end up hitting the table.
+		 *
+		 *shared() returns the process wide instance, which is loaded
+		 *lazily once and then used by all zeroth order functions.
+		 *Holders of the returned pointer keep their instance alive
+		 *across reset_databases(). The first call of a tier loads
+		 *(or builds) the table without holding any global lock, so it
+		 *may be made from inside TBB tasks, concurrent first calls of
+		 *the tier wait for that load.
+		 *
+		 *Every precision tier has its own files (default_path(tier))
+		 *and shared instance, computed and extended with the preset
+		 *policy of the tier, so fast tables never end up in the
+		 *standard or reference ones.
+		 *
+		 *A calculated table is built longest job first by
+		 *estimated_cost, get_build_timings() reports the time spent on
+		 *every entry (empty if the table was loaded from disk).
+		 */
+		class i_direct_database
+		{
+			private:
+				std::string path_to_data;
+				precision_policy precision;
+				integral_table table;
+				mutable integral_journal journal;
+				std::vector<build_timing> build_timings;
+
+				void calculate_database();
+
+			public:
+				i_direct_database(const std::string &path_to_data
+						= default_path(precision_tier::standard),
+						const precision_policy &precision
+						= precision_policy::standard());
+
+				static std::string default_path(
+						const precision_tier tier
+						= precision_tier::standard);
+				static std::shared_ptr<const i_direct_database> shared(
+						const precision_tier tier
+						= precision_tier::standard);
+
+				double get_i_direct(
+						const int n,
+						const int l,
+						const int n1,
+						const int l1,
+						const int k) const;
+
+				const std::vector<build_timing>& get_build_timings() const;
+
+				void import_json(const std::string &path);
+				void export_json(const std::string &path) const;
+		};
+
+		class i_exchange_database
+		{
+			private:
+				std::string path_to_data;
+				precision_policy precision;
+				integral_table table;
+				mutable integral_journal journal;
+				std::vector<build_timing> build_timings;
+
+				void calculate_database();
+
+			public:
+				i_exchange_database(const std::string &path_to_data
+						= default_path(precision_tier::standard),
+						const precision_policy &precision
+						= precision_policy::standard());
+
+				static std::string default_path(
+						const precision_tier tier
+						= precision_tier::standard);
+				static std::shared_ptr<const i_exchange_database> shared(
+						const precision_tier tier
+						= precision_tier::standard);
+
+				double get_i_exchange(
+						const int n,
+						const int l,
+						const int n1,
+						const int l1,
+						const int k) const;
+
+				const std::vector<build_timing>& get_build_timings() const;
+
+				void import_json(const std::string &path);
+				void export_json(const std::string &path) const;
+		};
+
+		/*
+		 *load (or calculate) both shared databases of a tier now
+		 *instead of on the first energy evaluation
+		 */
+		void preload_databases(
+				const precision_tier tier = precision_tier::standard);
+
+		/*
+		 *drop the shared databases of all tiers, the next use reloads
+		 *them from disk
+		 */
+		void reset_databases();
+
+	} /* end namespace zeroth_order */
+} /* end namespace effz */
+#endif
+#ifdef __cplusplus
+extern "C" {
+#endif
+	void effz_preload_databases();
+
+	void effz_reset_databases();
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* EFFZ_INTEGRAL_DATABASE_H */
@@ -22,23 +22,124 @@ limitations under the License.
 #include <functional>
 #include <memory>
 #include <utility>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <limits>
 #include <gsl/gsl_errno.h>
 #include <gsl/gsl_integration.h>
 
+#include "effz_gauss_kronrod.h"
+
 namespace effz{
 
 	namespace integration{
 
+		/*
+		 *gsl workspaces of the calling thread. Every running
+		 *integral (nested ones included) borrows one, released ones
+		 *are kept for the next borrow, so repeated quadratures do not
+		 *allocate. Workspaces are at least min_limit intervals large.
+		 */
+		class workspace_pool
+		{
+			public:
+				static const std::size_t min_limit = 1000;
+
+				class handle
+				{
+					private:
+						gsl_integration_workspace *workspace;
+					public:
+						explicit handle(gsl_integration_workspace *w)
+							: workspace(w) {}
+
+						handle(handle &&h) : workspace(h.workspace)
+						{
+							h.workspace = nullptr;
+						}
+
+						handle(const handle&) = delete;
+						void operator=(const handle&) = delete;
+
+						~handle()
+						{
+							if(workspace != nullptr){
+								local().release(workspace);
+							}
+						}
+
+						gsl_integration_workspace* get() const
+						{
+							return workspace;
+						}
+				};
+
+				static handle borrow(const std::size_t limit)
+				{
+					return handle(local().acquire(limit));
+				}
+
+				~workspace_pool()
+				{
+					for(auto w: free_workspaces){
+						gsl_integration_workspace_free(w);
+					}
+				}
+
+			private:
+				std::vector<gsl_integration_workspace*> free_workspaces;
+
+				workspace_pool() : free_workspaces() {}
+
+				static workspace_pool& local()
+				{
+					thread_local workspace_pool pool;
+					return pool;
+				}
+
+				gsl_integration_workspace* acquire(const std::size_t limit)
+				{
+					if(!free_workspaces.empty()
+							&& free_workspaces.back()->limit >= limit){
+						gsl_integration_workspace *w =
+							free_workspaces.back();
+						free_workspaces.pop_back();
+						return w;
+					}
+					const std::size_t size = min_limit;
+					return gsl_integration_workspace_alloc(
+							std::max(limit, size));
+				}
+
+				void release(gsl_integration_workspace *w)
+				{
+					free_workspaces.push_back(w);
+				}
+		};
+
+		/*
+		 *effz runs gsl with its error handler off, a failed gsl
+		 *routine returns its status to the quadrature instead of
+		 *aborting. The handler is a process wide setting of gsl: the
+		 *first quadrature switches it off once for the rest of the
+		 *process, a program calling gsl itself has to check the
+		 *returned status too.
+		 */
+		inline void disable_gsl_error_handler()
+		{
+			static const bool is_disabled =
+				(gsl_set_error_handler_off(), true);
+			static_cast<void>(is_disabled);
+		}
+
 		template <typename F>
 			class gsl_single_quad
 			{
 				private:
 					F f;
 					int limit;
-					std::unique_ptr<
-						gsl_integration_workspace,
-						std::function<void(gsl_integration_workspace*)>
-							> workspace;
+					workspace_pool::handle workspace;
 
 					static double gsl_wrapper(double x, void * p)
 					{
@@ -52,24 +153,33 @@ namespace effz{
 						:
 							f(f),
 							limit(limit),
-							workspace(
-									gsl_integration_workspace_alloc(limit),
-									gsl_integration_workspace_free) {}
+							workspace(workspace_pool::borrow(
+									static_cast<std::size_t>(limit))) {}
 
+					/*
+					 *the error estimate of gsl is stored in abserr if
+					 *it is not null. The gsl error handler is off
+					 *during the call, a failed integration only
+					 *returns its status, the tolerance counts as
+					 *missed then and abserr is at least the tolerance.
+					 */
 					double integrate(
 							const double min,
 							const double max,
 							const double epsabs,
-							const double epsrel)
+							const double epsrel,
+							double *abserr = nullptr)
 					{
 						gsl_function gsl_f;
 						gsl_f.function = &gsl_wrapper;
 						gsl_f.params = this;
 
 						double result, error;
+						int status = GSL_SUCCESS;
+						disable_gsl_error_handler();
 						if (!std::isinf(min) && !std::isinf(max))
 						{
-							gsl_integration_qag(
+							status = gsl_integration_qag(
 									&gsl_f, min, max,
 									epsabs, epsrel, limit,
 									GSL_INTEG_GAUSS21,
@@ -77,25 +187,30 @@ namespace effz{
 						}
 						else if(std::isinf(min) && !std::isinf(max))
 						{
-							gsl_integration_qagil(
+							status = gsl_integration_qagil(
 									&gsl_f, max,
 									epsabs, epsrel, limit,
 									workspace.get(), &result, &error);
 						}
 						else if(!std::isinf(min) && std::isinf(max))
 						{
-							gsl_integration_qagiu(
+							status = gsl_integration_qagiu(
 									&gsl_f, min,
 									epsabs, epsrel, limit,
 									workspace.get(), &result, &error);
 						}
 						else
 						{
-							gsl_integration_qagi(
+							status = gsl_integration_qagi(
 									&gsl_f, epsabs, epsrel, limit,
 									workspace.get(), &result, &error);
 						}
 
+						if(abserr != nullptr){
+							*abserr = (status == GSL_SUCCESS) ? error
+								: std::max(error, std::max(epsabs,
+											epsrel * std::abs(result)));
+						}
 						return result;
 					}
 			};
@@ -106,15 +221,146 @@ namespace effz{
 					const std::pair<double,double> &range,
 					const double epsabs = 1.49e-8,
 					const double epsrel = 1.49e-8,
-					const int limit = 250)
+					const int limit = 250,
+					double *abserr = nullptr)
 			{
 				return gsl_single_quad<F>(func, limit).integrate(
 						range.first,
 						range.second,
 						epsabs,
-						epsrel);
+						epsrel,
+						abserr);
+			}
+
+		/*
+		 *double exponential quadrature: the trapezoidal rule in t after
+		 *a change of variables whose weight decays double
+		 *exponentially, so a fixed t window covers the range and
+		 *halving the step roughly doubles the number of correct digits.
+		 *Every level adds only the new odd nodes, level l costs
+		 *(t_max - t_min) 2^l / initial_step evaluations in total.
+		 */
+		namespace double_exponential{
+
+			const double half_pi = 1.5707963267948966;
+			const double initial_step = 0.5;
+			const int max_level = 8;
+
+			/*
+			 *t windows (multiples of initial_step) outside of which the
+			 *weighted integrand is below double precision.
+			 *exp_sinh: x - a runs from 2e-19 to 2e11, enough for
+			 *integrands decaying at least like exp(-x/10).
+			 *tanh_sinh: the distance to the end points is below 1e-22.
+			 */
+			const double exp_sinh_t_min = -4.;
+			const double exp_sinh_t_max = 3.5;
+			const double tanh_sinh_t_max = 3.5;
+
+			/*
+			 *node(t) = w(t) f(x(t)), trapezoidal sums refined until two
+			 *consecutive levels (from the second refinement on) agree to
+			 *max(epsabs, epsrel |result|)
+			 */
+			template<typename Node>
+				double trapezoid(
+						const Node &node,
+						const double t_min,
+						const double t_max,
+						const double epsabs,
+						const double epsrel,
+						const int levels)
+				{
+					double step = initial_step;
+					const long num_steps =
+						std::lround((t_max - t_min) / step);
+					double sum = 0.;
+					for(long j = 0; j <= num_steps; ++j){
+						sum += node(t_min + static_cast<double>(j) * step);
+					}
+					double result = step * sum;
+					for(int level = 1; level <= levels; ++level){
+						step *= 0.5;
+						const long num_new = num_steps << (level - 1);
+						for(long j = 0; j < num_new; ++j){
+							sum += node(t_min
+									+ static_cast<double>(2 * j + 1) * step);
+						}
+						const double previous = result;
+						result = step * sum;
+						if(level > 1 && std::abs(result - previous)
+								<= std::max(epsabs, epsrel * std::abs(result))){
+							break;
+						}
+					}
+					return result;
+				}
+
+		} /* end namespace double_exponential */
+
+		/*
+		 *int_a^inf f(x) dx with x = a + exp(pi/2 sinh t),
+		 *for exponentially decaying f
+		 */
+		template<typename F>
+			double exp_sinh(
+					F f,
+					const double a,
+					const double epsabs = 1.49e-8,
+					const double epsrel = 1.49e-8,
+					const int levels = double_exponential::max_level)
+			{
+				using double_exponential::half_pi;
+				auto node = [&f,a](const double t){
+					const double e = std::exp(half_pi * std::sinh(t));
+					return half_pi * std::cosh(t) * e * f(a + e);
+				};
+				return double_exponential::trapezoid(node,
+						double_exponential::exp_sinh_t_min,
+						double_exponential::exp_sinh_t_max,
+						epsabs, epsrel, levels);
 			}
 
+		/*
+		 *int_a^b f(x) dx with x = (a+b)/2 + (b-a)/2 tanh(pi/2 sinh t),
+		 *the distance to the nearer end point is computed directly,
+		 *so nodes close to a or b keep their precision
+		 */
+		template<typename F>
+			double tanh_sinh(
+					F f,
+					const std::pair<double,double> &range,
+					const double epsabs = 1.49e-8,
+					const double epsrel = 1.49e-8,
+					const int levels = double_exponential::max_level)
+			{
+				using double_exponential::half_pi;
+				const double a = range.first;
+				const double b = range.second;
+				const double half_width = 0.5 * (b - a);
+				auto node = [&f,a,b,half_width](const double t){
+					const double u = half_pi * std::sinh(t);
+					const double cosh_u = std::cosh(u);
+					const double weight =
+						half_width * half_pi * std::cosh(t) / (cosh_u * cosh_u);
+					const double distance =
+						2. * half_width / (1. + std::exp(2. * std::abs(u)));
+					return weight * f(t < 0. ? a + distance : b - distance);
+				};
+				return double_exponential::trapezoid(node,
+						-double_exponential::tanh_sinh_t_max,
+						double_exponential::tanh_sinh_t_max,
+						epsabs, epsrel, levels);
+			}
+
+		/*
+		 *how int_0_inf and int_r_inf treat the infinite range.
+		 *cutoff: qag up to r_cutoff, then slabs of doubling width until
+		 *the last one contributes less than eps.
+		 *exp_sinh: a single exp_sinh quadrature of the whole range.
+		 */
+		enum class semi_infinite_rule {cutoff, exp_sinh};
+
 		template<typename F>
 			double int_0_inf(
 					F f,
@@ -173,6 +419,77 @@ namespace effz{
 				return res_r_cutoff;
 			}
 
+		/*
+		 *int_r_inf for an integrand decaying like d, one or two qag
+		 *calls up to decay_cutoff and the analytic decay_tail, see
+		 *int_r_inf_panels (also for the meaning of abserr)
+		 */
+		template<typename F>
+			double int_r_inf(
+					F f,
+					const double r,
+					const decay &d,
+					const double epsabs = 1.49e-8,
+					const double epsrel = 1.49e-8,
+					double *abserr = nullptr)
+			{
+				const double eps =
+					std::max(epsrel, std::numeric_limits<double>::epsilon());
+				double cutoff = decay_cutoff(d, r, eps);
+				double error = 0.;
+				double result = quad(f, {r,cutoff}, epsabs, epsrel, 250, &error);
+				double tail = f(cutoff) * decay_tail(d, cutoff);
+				if(std::abs(tail) > std::max(epsabs, epsrel * std::abs(result))){
+					const double next_cutoff = decay_cutoff(d, cutoff, eps);
+					double residue_error = 0.;
+					result += quad(f, {cutoff,next_cutoff}, epsabs, epsrel,
+							250, &residue_error);
+					error += residue_error;
+					tail = f(next_cutoff) * decay_tail(d, next_cutoff);
+				}
+
+				if(abserr != nullptr){
+					*abserr = error + std::abs(tail);
+				}
+				return result + tail;
+			}
+
+		template<typename F>
+			double int_0_inf(
+					F f,
+					const decay &d,
+					const double epsabs = 1.49e-8,
+					const double epsrel = 1.49e-8,
+					double *abserr = nullptr)
+			{
+				return int_r_inf(f, 0., d, epsabs, epsrel, abserr);
+			}
+
+		template<typename F>
+			double int_r_inf(
+					F f,
+					const double r,
+					const semi_infinite_rule rule,
+					const double eps = 1.49e-8)
+			{
+				if(rule == semi_infinite_rule::exp_sinh){
+					return exp_sinh(f, r, eps, eps);
+				}
+				return int_r_inf(f, r, 29., 20., eps);
+			}
+
+		template<typename F>
+			double int_0_inf(
+					F f,
+					const semi_infinite_rule rule,
+					const double eps = 1.49e-8)
+			{
+				if(rule == semi_infinite_rule::exp_sinh){
+					return exp_sinh(f, 0., eps, eps);
+				}
+				return int_0_inf(f, 29., 20., eps);
+			}
+
 	} /*namespace integration*/
 } /*namespace effz*/
 
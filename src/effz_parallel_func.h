@@ -18,109 +18,223 @@ limitations under the License.
 #define EFFZ_PARALLEL_FUNC_H
 
 #include <tbb/tbb.h>
+#include <tbb/blocked_range2d.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <numeric>
+#include <type_traits>
+#include <vector>
 
 namespace effz{
 
 	namespace parallel{
 
-		template<typename T, typename Container, typename Function>
-			class parallel_sum_data{
+		/*
+		 *fast: tbb::parallel_reduce, the rounding depends on how the
+		 *range was split at run time.
+		 *deterministic: tbb::parallel_deterministic_reduce with a fixed
+		 *grain, so the reduction tree depends only on the range, and
+		 *compensated summation. Results are bitwise identical for any
+		 *number of threads.
+		 */
+		enum class summation {fast, deterministic};
+
+		/*
+		 *Neumaier's variant of Kahan summation
+		 */
+		template<typename T>
+			class neumaier_sum{
 				private:
-					Container cont;
-					Function f;
+					T sum;
+					T compensation;
 				public:
-					typedef typename Container::const_iterator cont_it;
-					T my_sum;
-
-					void operator()(const tbb::blocked_range<cont_it> &r){
-						T sum = my_sum;
-						for(cont_it it = r.begin(); it != r.end(); ++it){
-							sum += f(*it);
+					neumaier_sum() : sum(), compensation() {}
+
+					void add(const T x){
+						const T t = sum + x;
+						if(std::abs(sum) >= std::abs(x)){
+							compensation += (sum - t) + x;
+						} else {
+							compensation += (x - t) + sum;
 						}
-						my_sum = sum;
+						sum = t;
 					}
 
-					parallel_sum_data(const parallel_sum_data &s,
-							tbb::split)
-						: cont(s.cont), f(s.f), my_sum(){}
-
-					parallel_sum_data(Container cont, Function f)
-						: cont(cont), f(f), my_sum() {}
+					void join(const neumaier_sum &s){
+						add(s.sum);
+						compensation += s.compensation;
+					}
 
-					void join(const parallel_sum_data &s){
-						my_sum += s.my_sum;
+					T value() const {
+						return sum + compensation;
 					}
 			};
 
-		template<typename T, typename Container, typename Function>
-			T parallel_sum(
-					const Container& cont, const Function& f){
-				parallel_sum_data<T,Container,Function>
-					ps(cont, f);
-
-				typedef typename Container::const_iterator cont_it;
-				const tbb::blocked_range<cont_it> cont_range(
-						cont.cbegin(), cont.cend());
+		/*
+		 *sum of the values passed to add by body(subrange, add) over
+		 *all subranges of range. Nothing but the range is copied on
+		 *a split.
+		 */
+		template<typename T, typename Range, typename Body>
+			T reduce_sum(const Range &range, const Body &body,
+					const summation mode = summation::fast){
+				if(mode == summation::fast){
+					return tbb::parallel_reduce(range, T(),
+							[&body](const Range &r, T sum) -> T {
+								body(r, [&sum](const T x){ sum += x; });
+								return sum;
+							},
+							std::plus<T>());
+				}
+				typedef neumaier_sum<T> acc_t;
+				return tbb::parallel_deterministic_reduce(range, acc_t(),
+						[&body](const Range &r, acc_t acc) -> acc_t {
+							body(r, [&acc](const T x){ acc.add(x); });
+							return acc;
+						},
+						[](acc_t acc, const acc_t &s) -> acc_t {
+							acc.join(s);
+							return acc;
+						}).value();
+			}
 
-				tbb::parallel_reduce(cont_range, ps);
+		/*
+		 *grain of the deterministic mode, part of the reduction tree
+		 */
+		const std::size_t deterministic_grain = 16;
 
-				return ps.my_sum;
+		/*
+		 *sum of f(el) over the elements of cont, which is only
+		 *referenced
+		 */
+		template<typename T, typename Container, typename Function>
+			T parallel_sum(const Container &cont, const Function &f,
+					const summation mode = summation::fast){
+				typedef typename Container::const_iterator cont_it;
+				const tbb::blocked_range<cont_it> range(
+						cont.cbegin(), cont.cend(),
+						mode == summation::fast ? 1 : deterministic_grain);
+				return reduce_sum<T>(range,
+						[&f](const tbb::blocked_range<cont_it> &r,
+							const auto &add){
+							for(cont_it it = r.begin(); it != r.end(); ++it){
+								add(f(*it));
+							}
+						}, mode);
 			}
 
+		/*
+		 *sum of f(i,j) over 0 <= i < rows, 0 <= j < cols. The index
+		 *space is split in both directions, so tasks stay balanced
+		 *when one of the extents is small.
+		 */
 		template<typename T, typename Function>
-			class parallel_table_data{
-				private:
-					std::vector<T> input;
-					Function f;
-				public:
-					typedef typename
-						std::result_of<Function(T)>::type return_type;
-					tbb::concurrent_vector<return_type> output;
-
-					typedef typename std::vector<T>::const_iterator vec_it;
-					void operator()
-						(const tbb::blocked_range<vec_it> &range){
-							tbb::concurrent_vector<return_type> vec
-								= output;
-							for(vec_it it = range.begin();
-									it != range.end();
-									++it){
-								vec.push_back(f(*it));
+			T parallel_sum_2d(const std::size_t rows,
+					const std::size_t cols,
+					const Function &f,
+					const summation mode = summation::fast){
+				typedef tbb::blocked_range2d<std::size_t> range_2d;
+				const std::size_t grain =
+					mode == summation::fast ? 1 : deterministic_grain;
+				return reduce_sum<T>(range_2d(0, rows, grain, 0, cols, grain),
+						[&f](const range_2d &r, const auto &add){
+							for(std::size_t i = r.rows().begin();
+									i != r.rows().end(); ++i){
+								for(std::size_t j = r.cols().begin();
+										j != r.cols().end(); ++j){
+									add(f(i,j));
+								}
 							}
-							output = vec;
-					}
-
-					parallel_table_data(parallel_table_data &tab,
-							tbb::split)
-						: input(tab.input), f(tab.f), output() {};
-
-					void join(const parallel_table_data &tab){
-						for(auto &el: tab.output){
-							output.push_back(el);
-						}
-					}
-
-					parallel_table_data(
-							const std::vector<T> &input,
-							Function f
-							) : input(input), f(f), output() {}
-			};
+						}, mode);
+			}
 
+		/*
+		 *f applied to every element of input, output[i] = f(input[i]).
+		 *The output is allocated once and each task writes its own
+		 *index range in place, so nothing is copied and the order
+		 *does not depend on the scheduling.
+		 */
 		template<typename T, typename Function>
-			auto parallel_table(const std::vector<T> &input, Function f){
-				typedef typename std::vector<T>::const_iterator vec_it;
-				tbb::blocked_range<vec_it>
-					range(input.cbegin(), input.cend());
-				parallel_table_data<T,Function> tab_dat(input, f);
-				parallel_reduce(range, tab_dat);
+			auto parallel_map(const std::vector<T> &input, const Function &f){
+				typedef typename
+					std::result_of<Function(const T&)>::type return_type;
+				std::vector<return_type> output(input.size());
+				tbb::parallel_for(
+						tbb::blocked_range<std::size_t>(0, input.size()),
+						[&input, &output, &f](
+							const tbb::blocked_range<std::size_t> &range){
+							for(std::size_t i = range.begin();
+									i != range.end(); ++i){
+								output[i] = f(input[i]);
+							}
+						});
+				return output;
+			}
 
+		/*
+		 *parallel_map for tasks of very different cost. The tasks are
+		 *handed out in order of decreasing cost(input[i]), every
+		 *worker of the task arena takes the next one as soon as it is
+		 *free (longest processing time first), so the expensive ones
+		 *are not left to a few cores at the end. seconds, if not null,
+		 *receives the wall time of every task, e.g. to calibrate the
+		 *cost model.
+		 *
+		 *The tasks run isolated, so while the calling thread waits for
+		 *them it can not pick up an outer task that takes a lock or
+		 *thread_local state the caller holds.
+		 */
+		template<typename T, typename Function, typename Cost>
+			auto parallel_map_by_cost(const std::vector<T> &input,
+					const Function &f,
+					const Cost &cost,
+					std::vector<double> *seconds = nullptr){
 				typedef typename
-					std::result_of<Function(T)>::type return_type;
-				std::vector<return_type> output;
-				for(auto &el: tab_dat.output){
-					output.push_back(el);
-				}
+					std::result_of<Function(const T&)>::type return_type;
+				const std::size_t size = input.size();
 
+				std::vector<double> costs(size);
+				for(std::size_t i = 0; i < size; ++i){
+					costs[i] = cost(input[i]);
+				}
+				std::vector<std::size_t> order(size);
+				std::iota(order.begin(), order.end(), std::size_t(0));
+				std::stable_sort(order.begin(), order.end(),
+						[&costs](const std::size_t i, const std::size_t j){
+							return costs[i] > costs[j];
+						});
+
+				std::vector<return_type> output(size);
+				if(seconds != nullptr){
+					seconds->assign(size, 0.);
+				}
+				std::atomic<std::size_t> next(0);
+				auto worker = [&](){
+					for(std::size_t j = next++; j < size; j = next++){
+						const std::size_t i = order[j];
+						const auto start = std::chrono::steady_clock::now();
+						output[i] = f(input[i]);
+						if(seconds != nullptr){
+							(*seconds)[i] = std::chrono::duration<double>(
+									std::chrono::steady_clock::now()
+									- start).count();
+						}
+					}
+				};
+				tbb::this_task_arena::isolate([&worker](){
+					tbb::task_group workers;
+					const int num_workers =
+						tbb::this_task_arena::max_concurrency();
+					for(int w = 0; w < num_workers; ++w){
+						workers.run(worker);
+					}
+					workers.wait();
+					});
 				return output;
 			}
 
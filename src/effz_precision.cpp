@@ -0,0 +1,70 @@
+/*
+Copyright 2018 Oleg Skoromnik
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "effz_precision.h"
+
+#include <stdexcept>
+
+namespace effz{
+	namespace zeroth_order{
+
+		precision_policy precision_policy::fast()
+		{
+			return precision_policy{precision_tier::fast,
+				1e-5, 1e-5, 1. / 32.};
+		}
+
+		precision_policy precision_policy::standard()
+		{
+			return precision_policy{precision_tier::standard,
+				1.49e-8, 1.49e-8, 1. / 256.};
+		}
+
+		precision_policy precision_policy::reference()
+		{
+			return precision_policy{precision_tier::reference,
+				1e-13, 1e-12, 1. / 1024.};
+		}
+
+		precision_policy precision_policy::preset(
+				const precision_tier tier)
+		{
+			switch(tier){
+				case precision_tier::fast:
+					return fast();
+				case precision_tier::standard:
+					return standard();
+				case precision_tier::reference:
+					return reference();
+			}
+			throw std::invalid_argument("precision_policy: unknown tier");
+		}
+
+		std::string precision_policy::database_suffix() const
+		{
+			switch(tier){
+				case precision_tier::fast:
+					return "_fast";
+				case precision_tier::standard:
+					return "";
+				case precision_tier::reference:
+					return "_reference";
+			}
+			throw std::invalid_argument("precision_policy: unknown tier");
+		}
+
+	} /*end namespace zeroth_order*/
+} /*end namespace effz*/
@@ -0,0 +1,64 @@
+/*
+Copyright 2018 Oleg Skoromnik
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef EFFZ_PRECISION_H
+#define EFFZ_PRECISION_H
+
+#include <string>
+
+namespace effz{
+	namespace zeroth_order{
+
+		/*
+		 *fast: radial integrals on a coarse logarithmic grid,
+		 *    about four to five digits, for screening many
+		 *    configurations.
+		 *standard: closed forms, quadrature to 1.49e-8 where there
+		 *    is none. This is what the functions without a
+		 *    precision argument use.
+		 *reference: closed forms only if their rounding bound meets
+		 *    the tolerance, otherwise quadrature to about 1e-12.
+		 */
+		enum class precision_tier {fast, standard, reference};
+
+		/*
+		 *how radial integrals are evaluated. Every tier keeps its own
+		 *shared databases in its own files, the standard tier uses
+		 *the original file names. Within a tier the databases are
+		 *built with the preset of that tier, a policy with other
+		 *tolerances only changes integrals evaluated directly.
+		 */
+		struct precision_policy{
+			precision_tier tier;
+			double epsabs;
+			double epsrel;
+			double grid_step;
+
+			static precision_policy fast();
+			static precision_policy standard();
+			static precision_policy reference();
+			static precision_policy preset(const precision_tier tier);
+
+			/*
+			 *appended to the database file names, empty for standard
+			 */
+			std::string database_suffix() const;
+		};
+
+	} /*end namespace zeroth_order*/
+} /*end namespace effz*/
+
+#endif /* EFFZ_PRECISION_H */
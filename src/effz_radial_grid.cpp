@@ -0,0 +1,387 @@
+/*
+Copyright 2018 Oleg Skoromnik
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "effz_radial_grid.h"
+
+#include "effz_radial_integrals.h"
+
+#include <vector>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace effz{
+
+	namespace radial{
+
+		namespace {
+
+			/*
+			 *h_rnl on all grid points from its polynomial expansion
+			 */
+			void tabulate_h_rnl(const int n, const int l,
+					const std::vector<double> &r, double *out)
+			{
+				const h_rnl_poly poly = make_h_rnl_poly(n,l);
+				for(std::size_t i = 0; i < r.size(); ++i){
+					double p = 0.;
+					for(std::size_t j = poly.c.size(); j-- > 0;){
+						p = p * r[i] + poly.c[j];
+					}
+					out[i] = p * std::pow(r[i], static_cast<double>(l))
+						* std::exp(-poly.alpha * r[i]);
+				}
+			}
+
+			/*
+			 *r^2 h_rnl(n,l,r) h_rnl(n1,l1,r) on the grid
+			 */
+			std::vector<double> pair_density(
+					const orbital_table &table,
+					const int n,
+					const int l,
+					const int n1,
+					const int l1)
+			{
+				const std::vector<double> &r = table.get_grid().get_r();
+				const double *r_nl = table.r_nl(n,l);
+				const double *r_n1l1 = table.r_nl(n1,l1);
+				std::vector<double> rho(r.size());
+				for(std::size_t i = 0; i < r.size(); ++i){
+					rho[i] = r[i] * r[i] * r_nl[i] * r_n1l1[i];
+				}
+				return rho;
+			}
+
+			/*
+			 *int_{x_(i-1)}^{x_i} g dx from the cubic through
+			 *g_(i-2), ..., g_(i+1), trapezoid next to the ends
+			 */
+			double segment(const double h,
+					const double g_m2, const double g_m1,
+					const double g_0, const double g_p1,
+					const bool is_interior)
+			{
+				if(!is_interior){
+					return 0.5 * h * (g_m1 + g_0);
+				}
+				return h / 24. * (-g_m2 + 13. * g_m1 + 13. * g_0 - g_p1);
+			}
+
+			/*
+			 *density of the pair (n,l),(n1,l1) does not depend on the
+			 *order, so the smaller orbital index goes first
+			 */
+			std::uint64_t pair_key(int n, int l, int n1, int l1, const int k)
+			{
+				if(n * (n - 1) / 2 + l > n1 * (n1 - 1) / 2 + l1){
+					std::swap(n,n1);
+					std::swap(l,l1);
+				}
+				auto field = [](const int x) -> std::uint64_t {
+					return static_cast<std::uint64_t>(x) & 0xfffu;
+				};
+				return field(k) << 48 | field(n) << 36 | field(l) << 24
+					| field(n1) << 12 | field(l1);
+			}
+
+		} /* end anonymous namespace */
+
+		radial_grid::radial_grid(const double r_min,
+				const double r_max,
+				const double h)
+			: h(h), r(), weights()
+		{
+			if(!(r_min > 0.) || !(r_max > r_min) || !(h > 0.)){
+				throw std::invalid_argument(
+						"radial_grid: require 0 < r_min < r_max, h > 0");
+			}
+			const double x_min = std::log(r_min);
+			const std::size_t size = static_cast<std::size_t>(
+					std::ceil((std::log(r_max) - x_min) / h)) + 1;
+			r.resize(size);
+			weights.resize(size);
+			for(std::size_t i = 0; i < size; ++i){
+				r[i] = std::exp(x_min + static_cast<double>(i) * h);
+				weights[i] = h * r[i];
+			}
+		}
+
+		radial_grid radial_grid::for_n_max(const int n_max, const double h)
+		{
+			/*
+			 *r^2 h_rnl^2 ~ r^(2n) exp(-2r/n) is below 1e-15 of its
+			 *maximum at r = 36 n
+			 */
+			return radial_grid(1.e-6, 36. * static_cast<double>(n_max), h);
+		}
+
+		std::size_t radial_grid::size() const
+		{
+			return r.size();
+		}
+
+		double radial_grid::get_step() const
+		{
+			return h;
+		}
+
+		const std::vector<double>& radial_grid::get_r() const
+		{
+			return r;
+		}
+
+		const std::vector<double>& radial_grid::get_weights() const
+		{
+			return weights;
+		}
+
+		orbital_table::orbital_table(const radial_grid &grid,
+				const int n_max)
+			: grid(grid), n_max(n_max), values()
+		{
+			if(n_max < 1){
+				throw std::invalid_argument("orbital_table: n_max < 1");
+			}
+			values.resize(offset(n_max + 1, 0));
+			for(int n = 1; n <= n_max; ++n){
+				for(int l = 0; l <= n - 1; ++l){
+					tabulate_h_rnl(n, l, grid.get_r(),
+							values.data() + offset(n,l));
+				}
+			}
+		}
+
+		int orbital_table::get_n_max() const
+		{
+			return n_max;
+		}
+
+		const radial_grid& orbital_table::get_grid() const
+		{
+			return grid;
+		}
+
+		std::size_t orbital_table::offset(const int n, const int l) const
+		{
+			const std::size_t index =
+				static_cast<std::size_t>(n * (n - 1) / 2 + l);
+			return index * grid.size();
+		}
+
+		const double* orbital_table::r_nl(const int n, const int l) const
+		{
+			if(n < 1 || n > n_max || l < 0 || l > n - 1){
+				throw std::out_of_range("orbital_table: n,l not tabulated");
+			}
+			return values.data() + offset(n,l);
+		}
+
+		std::vector<double> yk_potential(
+				const radial_grid &grid,
+				const std::vector<double> &rho,
+				const int k)
+		{
+			const std::vector<double> &r = grid.get_r();
+			const std::size_t size = grid.size();
+			if(rho.size() != size){
+				throw std::invalid_argument(
+						"yk_potential: density is not on the grid");
+			}
+			const double h = grid.get_step();
+			/*
+			 *dr = r dx, so in x the integrand is u = rho r
+			 */
+			std::vector<double> u(size);
+			for(std::size_t i = 0; i < size; ++i){
+				u[i] = rho[i] * r[i];
+			}
+
+			/*
+			 *forward: a_i = int_0^r_i rho (r1/r_i)^k dr1,
+			 *    a_i = e^(-kh) a_(i-1) + segment
+			 */
+			const double e_k = std::exp(-static_cast<double>(k) * h);
+			std::vector<double> a(size, 0.);
+			for(std::size_t i = 1; i < size; ++i){
+				const bool is_interior = i >= 2 && i + 1 < size;
+				const double seg = segment(h,
+						is_interior ? u[i - 2] * e_k * e_k : 0.,
+						u[i - 1] * e_k,
+						u[i],
+						is_interior ? u[i + 1] / e_k : 0.,
+						is_interior);
+				a[i] = e_k * a[i - 1] + seg;
+			}
+
+			/*
+			 *backward: b_i = int_r_i^inf rho (r_i/r1)^(k+1) dr1,
+			 *    b_i = e^(-(k+1)h) b_(i+1) + segment
+			 */
+			const double e_k1 = std::exp(-static_cast<double>(k + 1) * h);
+			std::vector<double> b(size, 0.);
+			for(std::size_t i = size - 1; i-- > 0;){
+				const bool is_interior = i >= 1 && i + 2 < size;
+				const double seg = segment(h,
+						is_interior ? u[i + 2] * e_k1 * e_k1 : 0.,
+						u[i + 1] * e_k1,
+						u[i],
+						is_interior ? u[i - 1] / e_k1 : 0.,
+						is_interior);
+				b[i] = e_k1 * b[i + 1] + seg;
+			}
+
+			std::vector<double> y(size);
+			for(std::size_t i = 0; i < size; ++i){
+				y[i] = (a[i] + b[i]) / r[i];
+			}
+			return y;
+		}
+
+		double contract(
+				const radial_grid &grid,
+				const std::vector<double> &rho,
+				const std::vector<double> &y)
+		{
+			const std::vector<double> &w = grid.get_weights();
+			double sum = 0.;
+			for(std::size_t i = 0; i < w.size(); ++i){
+				sum += w[i] * rho[i] * y[i];
+			}
+			return sum;
+		}
+
+		double grid_direct(
+				const orbital_table &table,
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k)
+		{
+			const radial_grid &grid = table.get_grid();
+			return contract(grid, pair_density(table,n,l,n,l),
+					yk_potential(grid, pair_density(table,n1,l1,n1,l1), k));
+		}
+
+		double grid_exchange(
+				const orbital_table &table,
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k)
+		{
+			const radial_grid &grid = table.get_grid();
+			const std::vector<double> rho =
+				pair_density(table,n,l,n1,l1);
+			return contract(grid, rho, yk_potential(grid, rho, k));
+		}
+
+		yk_cache::yk_cache(const orbital_table &table)
+			: table(table), densities(), potentials() {}
+
+		const std::vector<double>& yk_cache::density(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1)
+		{
+			const std::uint64_t key = pair_key(n,l,n1,l1,0);
+			auto it = densities.find(key);
+			if(it == densities.end()){
+				it = densities.emplace(key,
+						pair_density(table,n,l,n1,l1)).first;
+			}
+			return it->second;
+		}
+
+		const std::vector<double>& yk_cache::potential(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k)
+		{
+			const std::uint64_t key = pair_key(n,l,n1,l1,k);
+			auto it = potentials.find(key);
+			if(it == potentials.end()){
+				it = potentials.emplace(key,
+						yk_potential(table.get_grid(),
+							density(n,l,n1,l1), k)).first;
+			}
+			return it->second;
+		}
+
+		double yk_cache::i_direct(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k)
+		{
+			return contract(table.get_grid(), density(n,l,n,l),
+					potential(n1,l1,n1,l1,k));
+		}
+
+		double yk_cache::i_exchange(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k)
+		{
+			return contract(table.get_grid(), density(n,l,n1,l1),
+					potential(n,l,n1,l1,k));
+		}
+
+		std::size_t yk_cache::num_potentials() const
+		{
+			return potentials.size();
+		}
+
+		std::vector<double> grid_direct_table(
+				const orbital_table &table,
+				const std::vector<std::array<int,5>> &keys)
+		{
+			yk_cache cache(table);
+			std::vector<double> res;
+			res.reserve(keys.size());
+			for(const auto &key: keys){
+				res.push_back(cache.i_direct(
+							key[0], key[1], key[2], key[3], key[4]));
+			}
+			return res;
+		}
+
+		std::vector<double> grid_exchange_table(
+				const orbital_table &table,
+				const std::vector<std::array<int,5>> &keys)
+		{
+			yk_cache cache(table);
+			std::vector<double> res;
+			res.reserve(keys.size());
+			for(const auto &key: keys){
+				res.push_back(cache.i_exchange(
+							key[0], key[1], key[2], key[3], key[4]));
+			}
+			return res;
+		}
+
+	} /*end namespace radial*/
+
+} /*end namespace effz*/
@@ -0,0 +1,195 @@
+/*
+Copyright 2018 Oleg Skoromnik
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef EFFZ_RADIAL_GRID_H
+#define EFFZ_RADIAL_GRID_H
+
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <cstddef>
+#include <cstdint>
+
+namespace effz{
+
+	namespace radial{
+
+		/*
+		 *logarithmic mesh r_i = r_min exp(i h). With weights h r_i
+		 *the trapezoidal rule in x = log(r) is used, which converges
+		 *exponentially for integrands decaying at both ends.
+		 */
+		class radial_grid
+		{
+			public:
+				radial_grid(const double r_min,
+						const double r_max,
+						const double h);
+
+				/*
+				 *mesh wide enough for every h_rnl with n <= n_max,
+				 *the default step gives Slater integrals to ~1e-8
+				 */
+				static radial_grid for_n_max(const int n_max,
+						const double h = 1. / 256.);
+
+				std::size_t size() const;
+				double get_step() const;
+				const std::vector<double>& get_r() const;
+				const std::vector<double>& get_weights() const;
+
+			private:
+				double h;
+				std::vector<double> r;
+				std::vector<double> weights;
+		};
+
+		/*
+		 *h_rnl for all 1 <= n <= n_max, 0 <= l < n tabulated once on
+		 *a grid. Orbitals are stored one after the other in a single
+		 *contiguous array.
+		 */
+		class orbital_table
+		{
+			public:
+				orbital_table(const radial_grid &grid, const int n_max);
+
+				int get_n_max() const;
+				const radial_grid& get_grid() const;
+
+				/*
+				 *pointer to grid.size() values of h_rnl(n,l,r_i)
+				 */
+				const double* r_nl(const int n, const int l) const;
+
+			private:
+				radial_grid grid;
+				int n_max;
+				std::vector<double> values;
+
+				std::size_t offset(const int n, const int l) const;
+		};
+
+		/*
+		 *potential of a density rho given on the grid nodes
+		 *
+		 *    y_k(r) = r^-(k+1) int_0^r rho(r1) r1^k dr1
+		 *        + r^k int_r^inf rho(r1) r1^-(k+1) dr1
+		 *
+		 *(the usual Y^k(r) divided by r). Both cumulative integrals are
+		 *obtained for all nodes at once by one forward and one backward
+		 *recurrence in the scaled form of Hartree, so nothing overflows
+		 *for large k. Segments use a fourth order rule, error O(h^4).
+		 */
+		std::vector<double> yk_potential(
+				const radial_grid &grid,
+				const std::vector<double> &rho,
+				const int k);
+
+		/*
+		 *int_0^inf rho(r) y(r) dr on the grid
+		 */
+		double contract(
+				const radial_grid &grid,
+				const std::vector<double> &rho,
+				const std::vector<double> &y);
+
+		/*
+		 *fixed grid counterparts of zeroth_order::i_direct and
+		 *zeroth_order::i_exchange, all orbitals are taken from the table
+		 */
+		double grid_direct(
+				const orbital_table &table,
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k);
+
+		double grid_exchange(
+				const orbital_table &table,
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k);
+
+		/*
+		 *y_k potentials and pair densities memoised by their quantum
+		 *numbers. The direct potential depends only on (n1,l1,k), the
+		 *exchange one on the unordered pair (n,l),(n1,l1) and k, so each
+		 *is built once and contracted with all outer densities.
+		 *Not thread safe, use one cache per thread.
+		 */
+		class yk_cache
+		{
+			public:
+				explicit yk_cache(const orbital_table &table);
+
+				const std::vector<double>& density(
+						const int n,
+						const int l,
+						const int n1,
+						const int l1);
+
+				const std::vector<double>& potential(
+						const int n,
+						const int l,
+						const int n1,
+						const int l1,
+						const int k);
+
+				double i_direct(
+						const int n,
+						const int l,
+						const int n1,
+						const int l1,
+						const int k);
+
+				double i_exchange(
+						const int n,
+						const int l,
+						const int n1,
+						const int l1,
+						const int k);
+
+				std::size_t num_potentials() const;
+
+			private:
+				const orbital_table &table;
+				std::unordered_map<std::uint64_t, std::vector<double>>
+					densities;
+				std::unordered_map<std::uint64_t, std::vector<double>>
+					potentials;
+		};
+
+		/*
+		 *i_direct/i_exchange for every {n,l,n1,l1,k} in keys,
+		 *sharing the potentials between entries
+		 */
+		std::vector<double> grid_direct_table(
+				const orbital_table &table,
+				const std::vector<std::array<int,5>> &keys);
+
+		std::vector<double> grid_exchange_table(
+				const orbital_table &table,
+				const std::vector<std::array<int,5>> &keys);
+
+	} /*end namespace radial*/
+
+} /*end namespace effz*/
+
+#endif /* EFFZ_RADIAL_GRID_H */
@@ -0,0 +1,426 @@
+/*
+Copyright 2018 Oleg Skoromnik
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "effz_radial_integrals.h"
+
+#include <array>
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace effz{
+
+	namespace radial{
+
+		namespace {
+
+			/*
+			 *unevaluated sum hi + lo with |lo| <= ulp(hi)/2, about 32
+			 *significant digits from plain double operations (Dekker,
+			 *Knuth). The closed forms below sum terms that cancel by
+			 *up to eleven orders of magnitude at n = 7, which leaves
+			 *neither double nor long double anything to spare.
+			 */
+			struct double_double{
+				double hi;
+				double lo;
+			};
+
+			const double double_double_eps = 4.93038065763132e-32;
+
+			double_double to_double_double(const int i)
+			{
+				return {static_cast<double>(i), 0.};
+			}
+
+			double_double quick_two_sum(const double a, const double b)
+			{
+				const double s = a + b;
+				return {s, b - (s - a)};
+			}
+
+			double_double two_sum(const double a, const double b)
+			{
+				const double s = a + b;
+				const double bb = s - a;
+				return {s, (a - (s - bb)) + (b - bb)};
+			}
+
+			double_double two_prod(const double a, const double b)
+			{
+				const double split = 134217729.;
+				const double p = a * b;
+				const double ta = split * a;
+				const double a_hi = ta - (ta - a);
+				const double a_lo = a - a_hi;
+				const double tb = split * b;
+				const double b_hi = tb - (tb - b);
+				const double b_lo = b - b_hi;
+				return {p, ((a_hi * b_hi - p) + a_hi * b_lo + a_lo * b_hi)
+					+ a_lo * b_lo};
+			}
+
+			double_double operator+(const double_double a,
+					const double_double b)
+			{
+				const double_double s = two_sum(a.hi, b.hi);
+				const double_double t = two_sum(a.lo, b.lo);
+				const double_double u = quick_two_sum(s.hi, s.lo + t.hi);
+				return quick_two_sum(u.hi, u.lo + t.lo);
+			}
+
+			double_double operator-(const double_double a)
+			{
+				return {-a.hi, -a.lo};
+			}
+
+			double_double operator-(const double_double a,
+					const double_double b)
+			{
+				return a + (-b);
+			}
+
+			double_double operator*(const double_double a,
+					const double_double b)
+			{
+				const double_double p = two_prod(a.hi, b.hi);
+				return quick_two_sum(p.hi,
+						p.lo + (a.hi * b.lo + a.lo * b.hi));
+			}
+
+			double_double operator/(const double_double a,
+					const double_double b)
+			{
+				const double q1 = a.hi / b.hi;
+				const double_double r = a - b * double_double{q1, 0.};
+				const double q2 = r.hi / b.hi;
+				const double_double r2 = r - b * double_double{q2, 0.};
+				const double q3 = r2.hi / b.hi;
+				return quick_two_sum(q1, q2) + double_double{q3, 0.};
+			}
+
+			double_double& operator+=(double_double &a,
+					const double_double b)
+			{
+				return a = a + b;
+			}
+
+			double_double abs(const double_double a)
+			{
+				return a.hi < 0. ? -a : a;
+			}
+
+			double_double pow(double_double x, int e)
+			{
+				double_double result{1., 0.};
+				for(; e > 0; e /= 2){
+					if(e % 2 == 1){
+						result = result * x;
+					}
+					x = x * x;
+				}
+				return result;
+			}
+
+			long double to_long_double(const double_double a)
+			{
+				return static_cast<long double>(a.hi)
+					+ static_cast<long double>(a.lo);
+			}
+
+			const int max_factorial = 170;
+
+			const std::array<double_double, max_factorial + 1>&
+				factorials()
+				{
+					static const std::array<double_double,
+						max_factorial + 1> table = [](){
+							std::array<double_double,
+								max_factorial + 1> t;
+							t[0] = to_double_double(1);
+							for(int i = 1; i <= max_factorial; ++i){
+								t[i] = t[i - 1] * to_double_double(i);
+							}
+							return t;
+						}();
+					return table;
+				}
+
+			double_double factorial(const int n)
+			{
+				if(n < 0 || n > max_factorial){
+					throw std::out_of_range("factorial argument");
+				}
+				return factorials()[n];
+			}
+
+			/*
+			 *h_rnl = sqrt(norm2) sum_j q[j] r^(l+j) exp(-alpha*r), with
+			 *norm2 and q[j] rational, so the only rounding is that of
+			 *the double_double operations
+			 *
+			 *h_rnl = N (2r/n)^l exp(-r/n) L^{2l+1}_{n-l-1}(2r/n),
+			 *N^2 = (2/n)^3 (n-l-1)! / (2n (n+l)!),
+			 *L^a_m(x) = sum_j (-1)^j binom(m+a,m-j) x^j / j!
+			 */
+			struct exact_h_rnl{
+				int l;
+				double_double alpha;
+				double_double norm2;
+				std::vector<double_double> q;
+			};
+
+			exact_h_rnl make_exact_h_rnl(const int n, const int l)
+			{
+				const double_double two_over_n =
+					to_double_double(2) / to_double_double(n);
+				const int m = n - l - 1;
+
+				exact_h_rnl poly;
+				poly.l = l;
+				poly.alpha = to_double_double(1) / to_double_double(n);
+				poly.norm2 = pow(two_over_n, 3) * factorial(m)
+					/ (to_double_double(2 * n) * factorial(n + l));
+				poly.q.resize(m + 1);
+				double_double x_pow = pow(two_over_n, l);
+				for(int j = 0; j <= m; ++j){
+					const double_double binom = factorial(n + l)
+						/ (factorial(m - j) * factorial(2 * l + 1 + j));
+					const double_double term =
+						binom * x_pow / factorial(j);
+					poly.q[j] = (j % 2 == 0) ? term : -term;
+					x_pow = x_pow * two_over_n;
+				}
+				return poly;
+			}
+
+			/*
+			 *rho(r) = sum_i a[i] r^(p0+i) exp(-alpha*r), up to the
+			 *normalisation of the two radial functions
+			 */
+			struct exp_poly{
+				int p0;
+				double_double alpha;
+				std::vector<double_double> a;
+			};
+
+			/*
+			 *r^2 h_rnl(n,l,r) h_rnl(n1,l1,r) / (N N1)
+			 */
+			exp_poly pair_density(const exact_h_rnl &r_nl,
+					const exact_h_rnl &r_n1l1)
+			{
+				exp_poly rho;
+				rho.p0 = 2 + r_nl.l + r_n1l1.l;
+				rho.alpha = r_nl.alpha + r_n1l1.alpha;
+				rho.a.assign(r_nl.q.size() + r_n1l1.q.size() - 1,
+						double_double{0., 0.});
+				for(std::size_t i = 0; i < r_nl.q.size(); ++i){
+					for(std::size_t j = 0; j < r_n1l1.q.size(); ++j){
+						rho.a[i + j] += r_nl.q[i] * r_n1l1.q[j];
+					}
+				}
+				return rho;
+			}
+
+			/*
+			 *int_0^inf dx x^a exp(-alpha x)
+			 *    int_x^inf dy y^b exp(-beta y)
+			 *  = b!/beta^(b+1) sum_{i=0}^{b} beta^i (a+i)!
+			 *       / (i! (alpha+beta)^(a+i+1))
+			 *all terms are positive, so there is no cancellation here.
+			 */
+			double_double upper_nested(
+					const int a,
+					const int b,
+					const double_double alpha,
+					const double_double beta)
+			{
+				const double_double s = alpha + beta;
+				double_double term = factorial(a) * factorial(b)
+					/ (pow(beta, b + 1) * pow(s, a + 1));
+				double_double sum = term;
+				for(int i = 0; i < b; ++i){
+					term = term * beta * to_double_double(a + i + 1)
+						/ (to_double_double(i + 1) * s);
+					sum += term;
+				}
+				return sum;
+			}
+
+			/*
+			 *norm2 norm2_1 int_0^inf dr rho_a(r)
+			 *    int_0^inf dr1 rho_b(r1) r_<^k / r_>^(k+1)
+			 *split at r1 = r and both halves written as upper_nested.
+			 *The inner sums are rounded to double only at the end. The
+			 *error bound in abserr (if not null) is a few double_double
+			 *epsilons of the sum of |terms|, which the cancellation
+			 *can not bring near the double epsilon, plus the final
+			 *rounding.
+			 */
+			double slater_integral(
+					const exp_poly &rho_a,
+					const exp_poly &rho_b,
+					const double_double norm2,
+					const int k,
+					double *abserr)
+			{
+				double_double sum{0., 0.};
+				double_double abs_sum{0., 0.};
+				for(std::size_t i = 0; i < rho_a.a.size(); ++i){
+					const int p = rho_a.p0 + static_cast<int>(i);
+					for(std::size_t j = 0; j < rho_b.a.size(); ++j){
+						const int q = rho_b.p0 + static_cast<int>(j);
+						const double_double t =
+							upper_nested(p + k, q - k - 1,
+									rho_a.alpha, rho_b.alpha)
+							+ upper_nested(q + k, p - k - 1,
+									rho_b.alpha, rho_a.alpha);
+						const double_double term = rho_a.a[i] * rho_b.a[j] * t;
+						sum += term;
+						abs_sum += abs(term);
+					}
+				}
+				const double value = (sum * norm2).hi;
+				if(abserr != nullptr){
+					const int num_terms = static_cast<int>(
+							rho_a.a.size() * rho_b.a.size()
+							+ rho_a.p0 + rho_b.p0 + 2 * k + 16);
+					*abserr = num_terms * double_double_eps
+						* (abs_sum * norm2).hi
+						+ std::numeric_limits<double>::epsilon()
+						* std::abs(value);
+				}
+				return value;
+			}
+
+			bool is_valid_nl(const int n, const int l)
+			{
+				return n >= 1 && l >= 0 && l <= n - 1;
+			}
+
+		} /* end anonymous namespace */
+
+		h_rnl_poly make_h_rnl_poly(const int n, const int l)
+		{
+			if(!is_valid_nl(n,l)){
+				throw std::invalid_argument(
+						"h_rnl_poly: require n >= 1 and 0 <= l < n");
+			}
+			const exact_h_rnl exact = make_exact_h_rnl(n,l);
+			const long double norm = std::sqrt(to_long_double(exact.norm2));
+
+			h_rnl_poly poly;
+			poly.n = n;
+			poly.l = l;
+			poly.alpha = 1. / static_cast<double>(n);
+			poly.c.resize(exact.q.size());
+			for(std::size_t j = 0; j < exact.q.size(); ++j){
+				poly.c[j] = static_cast<double>(
+						norm * to_long_double(exact.q[j]));
+			}
+			return poly;
+		}
+
+		void h_rnl_values(const h_rnl_poly &poly,
+				const double *r,
+				double *out,
+				const std::size_t size)
+		{
+			for(std::size_t i = 0; i < size; ++i){
+				out[i] = poly.c.back();
+			}
+			for(std::size_t j = poly.c.size() - 1; j-- > 0;){
+				const double c = poly.c[j];
+				for(std::size_t i = 0; i < size; ++i){
+					out[i] = out[i] * r[i] + c;
+				}
+			}
+			for(int j = 0; j < poly.l; ++j){
+				for(std::size_t i = 0; i < size; ++i){
+					out[i] *= r[i];
+				}
+			}
+			for(std::size_t i = 0; i < size; ++i){
+				out[i] *= std::exp(-poly.alpha * r[i]);
+			}
+		}
+
+		bool is_closed_form_direct(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k)
+		{
+			return is_valid_nl(n,l) && is_valid_nl(n1,l1)
+				&& k >= 0 && k <= 2 * l + 1 && k <= 2 * l1 + 1;
+		}
+
+		bool is_closed_form_exchange(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k)
+		{
+			return is_valid_nl(n,l) && is_valid_nl(n1,l1)
+				&& k >= 0 && k <= l + l1 + 1;
+		}
+
+		double slater_direct(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k,
+				double *abserr)
+		{
+			if(!is_closed_form_direct(n,l,n1,l1,k)){
+				throw std::domain_error(
+						"slater_direct: no closed form for these n,l,k");
+			}
+			const exact_h_rnl r_nl = make_exact_h_rnl(n,l);
+			const exact_h_rnl r_n1l1 = make_exact_h_rnl(n1,l1);
+			return slater_integral(
+					pair_density(r_nl, r_nl),
+					pair_density(r_n1l1, r_n1l1),
+					r_nl.norm2 * r_n1l1.norm2, k, abserr);
+		}
+
+		double slater_exchange(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k,
+				double *abserr)
+		{
+			if(!is_closed_form_exchange(n,l,n1,l1,k)){
+				throw std::domain_error(
+						"slater_exchange: no closed form for these n,l,k");
+			}
+			const exact_h_rnl r_nl = make_exact_h_rnl(n,l);
+			const exact_h_rnl r_n1l1 = make_exact_h_rnl(n1,l1);
+			const exp_poly rho = pair_density(r_nl, r_n1l1);
+			return slater_integral(rho, rho,
+					r_nl.norm2 * r_n1l1.norm2, k, abserr);
+		}
+
+	} /*end namespace radial*/
+
+} /*end namespace effz*/
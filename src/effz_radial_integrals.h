@@ -0,0 +1,100 @@
+/*
+Copyright 2018 Oleg Skoromnik
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef EFFZ_RADIAL_INTEGRALS_H
+#define EFFZ_RADIAL_INTEGRALS_H
+
+#include <vector>
+#include <cstddef>
+
+namespace effz{
+
+	namespace radial{
+		/*
+		 *Closed form radial Coulomb (Slater) integrals between
+		 *hydrogen radial functions, i.e. charge = 1.
+		 *
+		 *    h_rnl(n,l,r) = sum_j c_j r^(l+j) exp(-r/n)
+		 *
+		 *so every integral is a finite sum of factorial/power terms.
+		 */
+
+		/*
+		 *polynomial expansion of h_rnl, coefficient c[j] multiplies
+		 *r^(l+j) exp(-alpha*r), alpha = 1/n
+		 */
+		struct h_rnl_poly{
+			int n;
+			int l;
+			double alpha;
+			std::vector<double> c;
+		};
+		h_rnl_poly make_h_rnl_poly(const int n, const int l);
+
+		/*
+		 *out[i] = h_rnl(r[i]) for i < size, straight line loops that
+		 *the compiler can vectorise
+		 */
+		void h_rnl_values(const h_rnl_poly &poly,
+				const double *r,
+				double *out,
+				const std::size_t size);
+
+		/*
+		 *true if the closed form converges term by term, i.e.
+		 *k is not larger than the small-r behaviour of the densities
+		 *allows. All k appearing in v_direct/v_exchange satisfy it.
+		 */
+		bool is_closed_form_direct(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k);
+
+		bool is_closed_form_exchange(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k);
+
+		/*
+		 *same meaning as zeroth_order::i_direct and
+		 *zeroth_order::i_exchange, abserr (if not null) receives a
+		 *bound of the rounding error
+		 */
+		double slater_direct(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k,
+				double *abserr = nullptr);
+
+		double slater_exchange(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k,
+				double *abserr = nullptr);
+
+	} /*end namespace radial*/
+
+} /*end namespace effz*/
+
+#endif /* EFFZ_RADIAL_INTEGRALS_H */
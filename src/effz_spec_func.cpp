@@ -16,6 +16,7 @@ limitations under the License.
 
 #include <config.h>
 #include "effz_spec_func.h"
+#include "effz_three_j_table.h"
 
 #include <gsl/gsl_sf_coulomb.h>
 #include <gsl/gsl_sf_coupling.h>
@@ -28,6 +29,7 @@ limitations under the License.
 #endif
 
 #include <cmath>
+#include <cstdlib>
 
 
 
@@ -111,18 +113,34 @@ namespace effz {
 	}
 #endif
 	double three_j_symbol(
-			const std::array<std::array<int,3>,2> &jm){
-		int two_ja = 2 * jm[0][0];
-		int two_jb = 2 * jm[0][1];
-		int two_jc = 2 * jm[0][2];
-		int two_ma = 2 * jm[1][0];
-		int two_mb = 2 * jm[1][1];
-		int two_mc = 2 * jm[1][2];
+			const int j1,
+			const int j2,
+			const int j3,
+			const int m1,
+			const int m2,
+			const int m3)
+	{
+		if(m1 + m2 + m3 != 0
+				|| j3 < std::abs(j1 - j2) || j3 > j1 + j2
+				|| std::abs(m1) > j1 || std::abs(m2) > j2
+				|| std::abs(m3) > j3){
+			return 0.;
+		}
+		const three_j_table &table = three_j_table::shared();
+		if(table.is_tabulated(j1, j2)){
+			return table.three_j(j1, j2, j3, m1, m2, m3);
+		}
 		return gsl_sf_coupling_3j(
-				two_ja,two_jb,two_jc,
-				two_ma,two_mb,two_mc);
+				2 * j1, 2 * j2, 2 * j3,
+				2 * m1, 2 * m2, 2 * m3);
+	}
 
+	double three_j_symbol(
+			const std::array<std::array<int,3>,2> &jm){
+		return three_j_symbol(jm[0][0], jm[0][1], jm[0][2],
+				jm[1][0], jm[1][1], jm[1][2]);
 	}
+
 	std::complex<double> sph_harm_y(
 			const int l,
 			const int m,
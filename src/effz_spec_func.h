@@ -97,6 +97,18 @@ namespace effz {
 		return - z * z / (2. * nn * nn);
 	}
 
+	/*
+	 *integer j and m, selection rules are checked with integer
+	 *arithmetic before anything is evaluated
+	 */
+	double three_j_symbol(
+			const int j1,
+			const int j2,
+			const int j3,
+			const int m1,
+			const int m2,
+			const int m3);
+
 	double three_j_symbol(const std::array<std::array<int,3>,2> &jm);
 
 	std::complex<double> sph_harm_y(
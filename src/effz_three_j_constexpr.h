@@ -0,0 +1,198 @@
+/*
+Copyright 2018 Oleg Skoromnik
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef EFFZ_THREE_J_CONSTEXPR_H
+#define EFFZ_THREE_J_CONSTEXPR_H
+
+namespace effz{
+
+	/*
+	 *Wigner 3j symbols from the Racah formula, usable in constant
+	 *expressions. Only integer j and m are supported.
+	 *
+	 *    three_j<1,1,2,0,0,0>::value
+	 *
+	 *is a compile time constant, racah_three_j(1,1,2,0,0,0) the same
+	 *value computed at run time.
+	 */
+	namespace racah{
+
+		constexpr int iabs(const int x)
+		{
+			return x < 0 ? -x : x;
+		}
+
+		constexpr int imin(const int a, const int b)
+		{
+			return a < b ? a : b;
+		}
+
+		constexpr int imax(const int a, const int b)
+		{
+			return a < b ? b : a;
+		}
+
+		constexpr long double factorial(const int n)
+		{
+			long double res = 1.L;
+			for(int i = 2; i <= n; ++i){
+				res *= static_cast<long double>(i);
+			}
+			return res;
+		}
+
+		/*
+		 *Newton iteration from above, it decreases monotonically
+		 *until it is converged in long double
+		 */
+		constexpr long double sqrt(const long double x)
+		{
+			if(!(x > 0.L)){
+				return 0.L;
+			}
+			long double y = x > 1.L ? x : 1.L;
+			for(;;){
+				const long double next = 0.5L * (y + x / y);
+				if(!(next < y)){
+					return y;
+				}
+				y = next;
+			}
+		}
+
+	} /*end namespace racah*/
+
+	constexpr double racah_three_j(
+			const int j1,
+			const int j2,
+			const int j3,
+			const int m1,
+			const int m2,
+			const int m3)
+	{
+		using racah::factorial;
+		if(m1 + m2 + m3 != 0
+				|| j3 < racah::iabs(j1 - j2) || j3 > j1 + j2
+				|| racah::iabs(m1) > j1 || racah::iabs(m2) > j2
+				|| racah::iabs(m3) > j3){
+			return 0.;
+		}
+		const long double delta = factorial(j1 + j2 - j3)
+			* factorial(j1 - j2 + j3) * factorial(-j1 + j2 + j3)
+			/ factorial(j1 + j2 + j3 + 1);
+		const long double norm = factorial(j1 + m1) * factorial(j1 - m1)
+			* factorial(j2 + m2) * factorial(j2 - m2)
+			* factorial(j3 + m3) * factorial(j3 - m3);
+		const int t_min = racah::imax(0,
+				racah::imax(j2 - j3 - m1, j1 - j3 + m2));
+		const int t_max = racah::imin(j1 + j2 - j3,
+				racah::imin(j1 - m1, j2 + m2));
+		long double sum = 0.L;
+		for(int t = t_min; t <= t_max; ++t){
+			const long double term = 1.L / (factorial(t)
+					* factorial(j3 - j2 + t + m1)
+					* factorial(j3 - j1 + t - m2)
+					* factorial(j1 + j2 - j3 - t)
+					* factorial(j1 - t - m1)
+					* factorial(j2 - t + m2));
+			sum += (t % 2 == 0) ? term : -term;
+		}
+		const long double sign =
+			(racah::iabs(j1 - j2 - m3) % 2 == 0) ? 1.L : -1.L;
+		return static_cast<double>(
+				sign * racah::sqrt(delta) * racah::sqrt(norm) * sum);
+	}
+
+	template<int j1, int j2, int j3, int m1, int m2, int m3>
+		struct three_j{
+			static constexpr double value =
+				racah_three_j(j1,j2,j3,m1,m2,m3);
+		};
+
+	template<int j1, int j2, int j3, int m1, int m2, int m3>
+		constexpr double three_j<j1,j2,j3,m1,m2,m3>::value;
+
+	/*
+	 *c^k(l,m,l1,m1), see three_j_table::c_k
+	 */
+	constexpr double racah_c_k(
+			const int l,
+			const int m,
+			const int l1,
+			const int m1,
+			const int k)
+	{
+		const double three_j_0 = racah_three_j(l,l1,k,0,0,0);
+		if(three_j_0 == 0.){
+			return 0.;
+		}
+		const double sign = (racah::iabs(m) % 2 == 0) ? 1. : -1.;
+		return sign * static_cast<double>(racah::sqrt(
+					static_cast<long double>((2 * l + 1) * (2 * l1 + 1))))
+			* three_j_0 * racah_three_j(l,l1,k,-m,m1,m - m1);
+	}
+
+	/*
+	 *c^k for all l, l1 <= small_l_max (s, p, d and f electrons),
+	 *filled by the compiler when declared constexpr
+	 */
+	const int small_l_max = 3;
+
+	struct small_c_k_table{
+		double values[small_l_max + 1][small_l_max + 1]
+			[2 * small_l_max + 1][2 * small_l_max + 1]
+			[2 * small_l_max + 1];
+
+		constexpr small_c_k_table() : values()
+		{
+			for(int l = 0; l <= small_l_max; ++l){
+				for(int l1 = 0; l1 <= small_l_max; ++l1){
+					for(int k = 0; k <= l + l1; ++k){
+						for(int m = -l; m <= l; ++m){
+							for(int m1 = -l1; m1 <= l1; ++m1){
+								values[l][l1][k][m + small_l_max]
+									[m1 + small_l_max] =
+									racah_c_k(l,m,l1,m1,k);
+							}
+						}
+					}
+				}
+			}
+		}
+
+		/*
+		 *0 outside the table and wherever the selection rules make
+		 *the coefficient vanish, like racah_c_k
+		 */
+		constexpr double c_k(
+				const int l,
+				const int m,
+				const int l1,
+				const int m1,
+				const int k) const
+		{
+			if(l < 0 || l > small_l_max || l1 < 0 || l1 > small_l_max
+					|| k < 0 || k > l + l1
+					|| racah::iabs(m) > l || racah::iabs(m1) > l1){
+				return 0.;
+			}
+			return values[l][l1][k][m + small_l_max][m1 + small_l_max];
+		}
+	};
+
+} /*end namespace effz*/
+
+#endif /* EFFZ_THREE_J_CONSTEXPR_H */
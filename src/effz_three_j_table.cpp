@@ -0,0 +1,129 @@
+/*
+Copyright 2018 Oleg Skoromnik
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#include "effz_three_j_table.h"
+
+#include "effz_three_j_constexpr.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace effz{
+
+	namespace {
+
+		/*
+		 *number of entries in the block of (j1,j2)
+		 */
+		std::size_t block_size(const int j1, const int j2)
+		{
+			return static_cast<std::size_t>(
+					(j1 + j2 - std::abs(j1 - j2) + 1)
+					* (2 * j1 + 1) * (2 * j2 + 1));
+		}
+
+	} /* end anonymous namespace */
+
+	three_j_table::three_j_table(const int l_max)
+		: l_max(l_max), offsets(), values()
+	{
+		if(l_max < 0){
+			throw std::invalid_argument("three_j_table: l_max < 0");
+		}
+		offsets.resize((l_max + 1) * (l_max + 1) + 1, 0);
+		for(int j1 = 0; j1 <= l_max; ++j1){
+			for(int j2 = 0; j2 <= l_max; ++j2){
+				const std::size_t i = block(j1,j2);
+				offsets[i + 1] = offsets[i] + block_size(j1,j2);
+			}
+		}
+		values.resize(offsets.back());
+		for(int j1 = 0; j1 <= l_max; ++j1){
+			for(int j2 = 0; j2 <= l_max; ++j2){
+				double *out = values.data() + offsets[block(j1,j2)];
+				for(int j3 = std::abs(j1 - j2); j3 <= j1 + j2; ++j3){
+					for(int m1 = -j1; m1 <= j1; ++m1){
+						for(int m2 = -j2; m2 <= j2; ++m2){
+							*out++ = racah_three_j(j1, j2, j3,
+									m1, m2, -(m1 + m2));
+						}
+					}
+				}
+			}
+		}
+	}
+
+	const three_j_table& three_j_table::shared()
+	{
+		static const three_j_table table;
+		return table;
+	}
+
+	int three_j_table::get_l_max() const
+	{
+		return l_max;
+	}
+
+	std::size_t three_j_table::block(const int j1, const int j2) const
+	{
+		return static_cast<std::size_t>(j1 * (l_max + 1) + j2);
+	}
+
+	bool three_j_table::is_tabulated(const int j1, const int j2) const
+	{
+		return j1 >= 0 && j1 <= l_max && j2 >= 0 && j2 <= l_max;
+	}
+
+	double three_j_table::three_j(
+			const int j1,
+			const int j2,
+			const int j3,
+			const int m1,
+			const int m2,
+			const int m3) const
+	{
+		if(j3 < std::abs(j1 - j2) || j3 > j1 + j2
+				|| m1 + m2 + m3 != 0
+				|| std::abs(m1) > j1 || std::abs(m2) > j2
+				|| std::abs(m3) > j3){
+			return 0.;
+		}
+		const std::size_t index = offsets[block(j1,j2)]
+			+ static_cast<std::size_t>(
+					((j3 - std::abs(j1 - j2)) * (2 * j1 + 1) + m1 + j1)
+					* (2 * j2 + 1) + m2 + j2);
+		return values[index];
+	}
+
+	double three_j_table::c_k(
+			const int l,
+			const int m,
+			const int l1,
+			const int m1,
+			const int k) const
+	{
+		const double three_j_0 = three_j(l,l1,k,0,0,0);
+		if(three_j_0 == 0.){
+			return 0.;
+		}
+		const double sign = (m % 2 == 0) ? 1. : -1.;
+		return sign * std::sqrt(static_cast<double>(
+					(2 * l + 1) * (2 * l1 + 1)))
+			* three_j_0 * three_j(l,l1,k,-m,m1,m - m1);
+	}
+
+} /*end namespace effz*/
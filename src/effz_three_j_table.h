@@ -0,0 +1,84 @@
+/*
+Copyright 2018 Oleg Skoromnik
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+
+#ifndef EFFZ_THREE_J_TABLE_H
+#define EFFZ_THREE_J_TABLE_H
+
+#include <cstddef>
+#include <vector>
+
+namespace effz{
+
+	/*
+	 *Wigner 3j symbols (j1 j2 j3; m1 m2 m3) with integer arguments,
+	 *j1, j2 <= l_max and all allowed j3, m1, m2 (m3 = -m1-m2),
+	 *computed once with racah_three_j. Each (j1,j2) owns a block indexed by
+	 *(j3 - |j1-j2|, m1 + j1, m2 + j2), so only allowed entries are
+	 *stored.
+	 */
+	class three_j_table
+	{
+		public:
+			static const int default_l_max = 6;
+
+			explicit three_j_table(const int l_max = default_l_max);
+
+			/*
+			 *instance with default_l_max, built on first use
+			 */
+			static const three_j_table& shared();
+
+			int get_l_max() const;
+
+			bool is_tabulated(const int j1, const int j2) const;
+
+			/*
+			 *0 if the selection rules are violated, j1 and j2 must
+			 *be tabulated
+			 */
+			double three_j(
+					const int j1,
+					const int j2,
+					const int j3,
+					const int m1,
+					const int m2,
+					const int m3) const;
+
+			/*
+			 *Condon-Shortley coefficient
+			 *    c^k(l,m,l1,m1) = (-1)^m sqrt((2l+1)(2l1+1))
+			 *        (l l1 k; 0 0 0) (l l1 k; -m m1 m-m1)
+			 *so that three_j_prod_direct = c^k(l,m,l,m) c^k(l1,m1,l1,m1)
+			 *and three_j_prod_exchange = c^k(l,m,l1,m1)^2
+			 */
+			double c_k(
+					const int l,
+					const int m,
+					const int l1,
+					const int m1,
+					const int k) const;
+
+		private:
+			int l_max;
+			std::vector<std::size_t> offsets;
+			std::vector<double> values;
+
+			std::size_t block(const int j1, const int j2) const;
+	};
+
+} /*end namespace effz*/
+
+#endif /* EFFZ_THREE_J_TABLE_H */
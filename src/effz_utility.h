@@ -31,12 +31,12 @@ limitations under the License.
 
 namespace effz{
 	template <typename T>
-		bool in_range(T begin, T end, T num){
-			std::vector<T> range(std::abs(end - begin) + 1);
-			std::iota(range.begin(), range.end(), begin);
-			return std::any_of(range.cbegin(), range.cend(),
-					[num](T n){return n == num;}
-					);
+		constexpr bool in_range(T begin, T end, T num){
+			/*
+			 *the |end - begin| + 1 integers starting at begin
+			 */
+			const T last = begin + (end < begin ? begin - end : end - begin);
+			return begin <= num && num <= last;
 		}
 	template<typename... Ts>
 		constexpr auto make_array(Ts&&... ts)
@@ -16,16 +16,16 @@ limitations under the License.
 
 #include "effz_zeroth_order.h"
 
-#include "effz_config.h"
+#include "effz_integral_database.h"
 #include "effz_spec_func.h"
+#include "effz_three_j_table.h"
+#include "effz_three_j_constexpr.h"
 #include "effz_utility.h"
 #include "effz_integration.h"
+#include "effz_gauss_kronrod.h"
 #include "effz_parallel_func.h"
-
-#include "cereal/types/vector.hpp"
-#include "cereal/types/array.hpp"
-#include "cereal/types/tuple.hpp"
-#include "cereal/archives/json.hpp"
+#include "effz_radial_integrals.h"
+#include "effz_radial_grid.h"
 
 #include <gsl/gsl_sf_coupling.h>
 #include <array>
@@ -36,325 +36,163 @@ limitations under the License.
 #include <fstream>
 #include <tuple>
 #include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
 
 namespace effz {
 	namespace zeroth_order {
 		namespace {
 
-			class i_direct_database
-			{
-				private:
-					std::string path_to_data;
-
-					typedef std::tuple<std::array<int,5>,double> elem_t;
-					std::vector<elem_t> database;
-
-					friend double i_direct(
-							const int n,
-							const int l,
-							const int n1,
-							const int l1,
-							const int k);
-
-					void calculate_database();
-					void save_database(std::fstream &s);
-					void load_database(std::fstream &s);
-
-				public:
-					i_direct_database(const std::string &path_to_data
-							= config::shared_config().get_database_dir()
-							+ "/i_direct_database.txt");
-
-					double get_i_direct(
-							const int n,
-							const int l,
-							const int n1,
-							const int l1,
-							const int k);
-
-			};
-
-			class i_exchange_database
-			{
-				private:
-					std::string path_to_data;
-
-					typedef std::tuple<std::array<int,5>,double> elem_t;
-					std::vector<elem_t> database;
-
-					friend double i_exchange(
-							const int n,
-							const int l,
-							const int n1,
-							const int l1,
-							const int k);
-
-					void calculate_database();
-					void save_database(std::fstream &s);
-					void load_database(std::fstream &s);
-
-				public:
-					i_exchange_database(const std::string &path_to_data
-							= config::shared_config().get_database_dir()
-							+ "/i_exchange_database.txt");
-
-					double get_i_exchange(
-							const int n,
-							const int l,
-							const int n1,
-							const int l1,
-							const int k);
-
-			};
-
-			void i_direct_database::calculate_database()
-			{
-				std::vector<std::array<int,5>> direct_quantum_nums;
-				for(int n = 1; n <= 6; ++n){
-					for(int l = 0; l <= n - 1; ++l){
-						for(int n1 = 1; n1 <= 6; ++n1){
-							for(int l1 = 0; l1 <= n1 - 1; ++l1){
-								for(int k = 0; k <= std::min(l,l1); ++k){
-									direct_quantum_nums
-										.push_back({n,l,n1,l1,2*k});
-								}
-							}
-						}
-					}
-				}
-
-				for(int n = 1; n <= 6; ++n){
-					for(int l = 0; l <= n - 1; ++l){
-						for(int l1 = 0; l1 <= 2; ++l1){
-							for(int k = 0; k <= std::min(l,l1); ++k){
-								direct_quantum_nums
-									.push_back({n,l,7,l1,2*k});
-							}
-						}
-					}
-				}
-
-				for(int n1 = 1; n1 <= 6; ++n1){
-					for(int l1 = 0; l1 <= n1 - 1; ++l1){
-						for(int l = 0; l <= 2; ++l){
-							for(int k = 0; k <= std::min(l,l1); ++k){
-								direct_quantum_nums
-									.push_back({7,l,n1,l1,2*k});
-							}
-						}
-					}
-				}
-
-				for(int l = 0; l <= 2; ++l){
-					for(int l1 = 0; l1 <= 2; ++l1){
-						for(int k = 0; k <= std::min(l,l1); ++k){
-							direct_quantum_nums.push_back({7,l,7,l1,2*k});
-						}
-					}
-				}
-
-				auto f_to_map
-					= [](const std::array<int,5> &arr)
-					-> std::tuple<std::array<int,5>, double>{
-						return std::make_tuple(
-								arr,
-								i_direct(
-									arr[0],
-									arr[1],
-									arr[2],
-									arr[3],
-									arr[4])
-								);
-					};
-
-				database = effz::parallel::parallel_table(
-						direct_quantum_nums, f_to_map);
-			}
-
-			void i_direct_database::save_database(std::fstream &s)
-			{
-				cereal::JSONOutputArchive output(s);
-				output(CEREAL_NVP(database));
-			}
+			/*
+			 *angular coefficients of s, p, d and f electrons,
+			 *evaluated by the compiler
+			 */
+			constexpr small_c_k_table small_c_k{};
 
-			void i_direct_database::load_database(std::fstream &s)
+			bool is_small(const int l, const int l1)
 			{
-				cereal::JSONInputArchive input(s);
-				input(CEREAL_NVP(database));
+				return l >= 0 && l <= small_l_max
+					&& l1 >= 0 && l1 <= small_l_max;
 			}
 
-			i_direct_database::i_direct_database(
-					const std::string &path_to_data)
-				: path_to_data(path_to_data), database()
-			{
-				std::fstream s;
-				try{
-					s.open(path_to_data);
-					if(!s.is_open()){
-						s.open(path_to_data, s.out | s.trunc);
-						//std::cout << "calc" << "\n";
-						calculate_database();
-						save_database(s);
-					} else {
-						//std::cout << "load" << "\n";
-						load_database(s);
+			/*
+			 *int_0^inf r^2 outer(r) (r^-(k+1) int_0^r inner(r1) r1^(k+2) dr1
+			 *+ r^k int_r^inf inner(r1) r1^(1-k) dr1) dr for all k in ks.
+			 *outer and inner fill the pair densities on a panel and
+			 *decay like outer_decay and inner_decay, all multipoles are
+			 *integrated on the same nodes. The inner integrands carry
+			 *the powers of r, (r1/r)^k r1^2/r and (r/r1)^k r1, so they
+			 *stay of order one and the absolute tolerance is meaningful
+			 *for every k.
+			 *Half of epsabs goes to the inner integrals. Their errors
+			 *are integrated with the same weight as the values, as
+			 *num_k more components, and added to the error of the
+			 *outer quadrature in abserr.
+			 */
+			template<typename Outer, typename Inner>
+				std::vector<double> multipole_quad(
+						const Outer &outer,
+						const effz::integration::decay &outer_decay,
+						const Inner &inner,
+						const effz::integration::decay &inner_decay,
+						const std::vector<int> &ks,
+						const double epsabs,
+						const double epsrel,
+						double *abserr)
+				{
+					const std::size_t num_k = ks.size();
+					if(num_k == 0){
+						return std::vector<double>();
 					}
-				} catch (const std::exception &e){
-					std::cerr << "error happened" << e.what();
-					throw;
-				}
-				s.close();
-			}
 
-			double i_direct_database::get_i_direct(
-					const int n,
-					const int l,
-					const int n1,
-					const int l1,
-					const int k)
-			{
-				auto find_i_direct
-					= [n,l,n1,l1,k](
-							const std::tuple<std::array<int,5>, double> &el)
-					-> bool
-					{
-						return std::get<0>(el)
-							== std::array<int,5>({n,l,n1,l1,k});
-					};
-				auto element = std::find_if(
-						database.cbegin(),
-						database.cend(),
-						find_i_direct);
-				if(element != database.cend()){
-					return std::get<1>(*element);
-				} else {
-					return i_direct(n,l,n1,l1,k);
-				}
-			}
-
-			void i_exchange_database::calculate_database()
-			{
-				std::vector<std::array<int,5>> exchange_quantum_nums;
-				for(int n = 1; n <= 6; ++n){
-					for(int l = 0; l <= n - 1; ++l){
-						for(int n1 = 1; n1 <= 6; ++n1){
-							for(int l1 = 0; l1 <= n1 - 1; ++l1){
-								for(int k = std::abs(l-l1); k <= l+l1; ++k){
-									exchange_quantum_nums
-										.push_back({n,l,n1,l1,k});
+					/*
+					 *y_c = inner(x) x^2 (x/r)^(sign k_c) / x^power
+					 */
+					auto inner_f = [&inner,&ks,num_k](const double r,
+							const double sign, const double power){
+						return [&inner,&ks,num_k,r,sign,power](
+								const double *x, double *y,
+								const std::size_t size){
+							inner(x, y, size);
+							for(std::size_t c = num_k; c-- > 0;){
+								const double k = sign * static_cast<double>(ks[c]);
+								for(std::size_t i = 0; i < size; ++i){
+									y[c * size + i] = y[i] * x[i] * x[i]
+										* std::pow(x[i] / r, k)
+										/ std::pow(x[i], power);
 								}
 							}
-						}
-					}
-				}
-
-				for(int n = 1; n <= 6; ++n){
-					for(int l = 0; l <= n - 1; ++l){
-						for(int l1 = 0; l1 <= 1; ++l1){
-							for(int k = std::abs(l-l1); k <= l+l1; ++k){
-								exchange_quantum_nums
-									.push_back({n,l,7,l1,k});
-							}
-						}
-					}
-				}
-
-				for(int n1 = 1; n1 <= 6; ++n1){
-					for(int l1 = 0; l1 <= n1 - 1; ++l1){
-						for(int l = 0; l <= 1; ++l){
-							for(int k = std::abs(l-l1); k <= l+l1; ++k){
-								exchange_quantum_nums
-									.push_back({7,l,n1,l1,k});
+						};
+					};
+					const effz::integration::decay inner_r_inf_decay =
+						{inner_decay.alpha, inner_decay.degree + 1.};
+					const effz::integration::decay integral_decay =
+						{outer_decay.alpha, outer_decay.degree + 2.};
+
+					const double inner_epsabs = 0.5 * epsabs;
+					auto integral = [&](const double *x, double *y,
+							const std::size_t size){
+						double density[effz::integration::max_panel_nodes];
+						std::vector<double> error_0_r(num_k);
+						std::vector<double> error_r_inf(num_k);
+						outer(x, density, size);
+						for(std::size_t i = 0; i < size; ++i){
+							const double r = x[i];
+							const std::vector<double> inner_0_r =
+								effz::integration::quad_panels_multi(
+										inner_f(r, 1., 0.), num_k, {0.,r},
+										inner_epsabs, epsrel, 250,
+										error_0_r.data());
+							const std::vector<double> inner_r_inf =
+								effz::integration::int_r_inf_panels_multi(
+										inner_f(r, -1., 1.), num_k, r,
+										inner_r_inf_decay, inner_epsabs,
+										epsrel, error_r_inf.data());
+							for(std::size_t c = 0; c < num_k; ++c){
+								y[c * size + i] = r * density[i]
+									* (inner_0_r[c] + r * inner_r_inf[c]);
+								y[(num_k + c) * size + i] =
+									r * std::abs(density[i])
+									* (error_0_r[c] + r * error_r_inf[c]);
 							}
 						}
-					}
-				}
+					};
 
-				for(int l = 0; l <= 1; ++l){
-					for(int l1 = 0; l1 <= 1; ++l1){
-						for(int k = std::abs(l-l1); k <= l+l1; ++k){
-							exchange_quantum_nums.push_back({7,l,7,l1,k});
+					std::vector<double> error(2 * num_k);
+					std::vector<double> res =
+						effz::integration::int_0_inf_panels_multi(
+								integral, 2 * num_k, integral_decay,
+								0.5 * epsabs, epsrel, error.data());
+					if(abserr != nullptr){
+						for(std::size_t c = 0; c < num_k; ++c){
+							abserr[c] = error[c] + res[num_k + c]
+								+ error[num_k + c];
 						}
 					}
+					res.resize(num_k);
+					return res;
 				}
 
-				auto f_to_map
-					= [](const std::array<int,5> &arr)
-					-> std::tuple<std::array<int,5>, double>{
-						return std::make_tuple(
-								arr,
-								i_exchange(
-									arr[0],
-									arr[1],
-									arr[2],
-									arr[3],
-									arr[4])
-								);
-					};
-
-				database = effz::parallel::parallel_table(
-						exchange_quantum_nums, f_to_map);
-			}
-
-			void i_exchange_database::save_database(std::fstream &s)
+			/*
+			 *orbitals of the fast tier, kept per thread and rebuilt
+			 *when a larger n or another step is asked for
+			 */
+			const effz::radial::orbital_table& fast_orbitals(
+					const int n_max,
+					const double step)
 			{
-				cereal::JSONOutputArchive output(s);
-				output(CEREAL_NVP(database));
+				const int table_n_max = std::max(n_max, 7);
+				thread_local std::unique_ptr<effz::radial::orbital_table>
+					table;
+				if(!table || table->get_n_max() < table_n_max
+						|| table->get_grid().get_step() != step){
+					table.reset(new effz::radial::orbital_table(
+								effz::radial::radial_grid::for_n_max(
+									table_n_max, step),
+								table_n_max));
+				}
+				return *table;
 			}
 
-			void i_exchange_database::load_database(std::fstream &s)
+			/*
+			 *the error is only the rounding of the value itself,
+			 *quadrature can not do better
+			 */
+			bool is_rounding_limited(const estimate &e)
 			{
-				cereal::JSONInputArchive input(s);
-				input(CEREAL_NVP(database));
+				const double eps = std::numeric_limits<double>::epsilon();
+				return e.error <= 4. * eps * std::abs(e.value);
 			}
 
-			i_exchange_database::i_exchange_database(
-					const std::string &path_to_data)
-				: path_to_data(path_to_data), database()
+			bool is_within(const double error, const double value,
+					const precision_policy &precision)
 			{
-				std::fstream s;
-				try{
-					s.open(path_to_data);
-					if(!s.is_open()){
-						s.open(path_to_data, s.out | s.trunc);
-						//std::cout << "calc" << "\n";
-						calculate_database();
-						save_database(s);
-					} else {
-						//std::cout << "load" << "\n";
-						load_database(s);
-					}
-				} catch (const std::exception &e){
-					std::cerr << "error happened " << e.what();
-					throw;
-				}
-				s.close();
-			}
-
-			double i_exchange_database::get_i_exchange(
-					const int n,
-					const int l,
-					const int n1,
-					const int l1,
-					const int k)
-			{
-				auto find_i_exchange
-					= [n,l,n1,l1,k](
-							const std::tuple<std::array<int,5>, double> &el)
-					-> bool
-					{
-						return std::get<0>(el)
-							== std::array<int,5>({n,l,n1,l1,k});
-					};
-				auto element = std::find_if(
-						database.cbegin(),
-						database.cend(),
-						find_i_exchange);
-				if(element != database.cend()){
-					return std::get<1>(*element);
-				} else {
-					return i_exchange(n,l,n1,l1,k);
-				}
+				return error <= std::max(precision.epsabs,
+						precision.epsrel * std::abs(value));
 			}
 
 		} /* end anonymous namespace */
@@ -366,14 +204,22 @@ namespace effz {
 				const int m1,
 				const int k)
 		{
+			if(is_small(l,l1)){
+				return small_c_k.c_k(l,m,l,m,k)
+					* small_c_k.c_k(l1,m1,l1,m1,k);
+			}
+			const three_j_table &table = three_j_table::shared();
+			if(table.is_tabulated(l,l1)){
+				return table.c_k(l,m,l,m,k) * table.c_k(l1,m1,l1,m1,k);
+			}
 			const double three_j_1 =
-				effz::three_j_symbol({{{l,l,k},{0,0,0}}});
+				effz::three_j_symbol(l,l,k,0,0,0);
 			const double three_j_2 =
-				effz::three_j_symbol({{{l,l,k},{m,-m,0}}});
+				effz::three_j_symbol(l,l,k,m,-m,0);
 			const double three_j_3 =
-				effz::three_j_symbol({{{l1,l1,k},{0,0,0}}});
+				effz::three_j_symbol(l1,l1,k,0,0,0);
 			const double three_j_4 =
-				effz::three_j_symbol({{{l1,l1,k},{m1,-m1,0}}});
+				effz::three_j_symbol(l1,l1,k,m1,-m1,0);
 			int prefactor = ((m+m1)%2 == 0) ? 1 : -1;
 			prefactor *= (2 * l + 1) * (2 * l1 + 1);
 
@@ -389,41 +235,111 @@ namespace effz {
 				const int k
 				)
 		{
-			auto inner_0_r =
-				[n1,l1,k](double r) -> double {
-					return 1. / std::pow(r, static_cast<double>(k) + 1)
-						* effz::integration::quad(
-								[n1,l1,k](double r1) -> double {
-								double h_rnl =
-								std::abs(effz::h_rnl(n1,l1,r1));
-								return h_rnl * h_rnl
-								* std::pow(r1,static_cast<double>(k) + 2);
-								}, {0.,r});
-				};
+			return i_direct(n,l,n1,l1,k,precision_policy::standard());
+		}
 
-			auto inner_r_inf =
-				[n1,l1,k](double r) -> double {
-					return std::pow(r, static_cast<double>(k))
-						* effz::integration::int_r_inf(
-								[n1,l1,k](double r1) -> double {
-								double h_rnl =
-								std::abs(effz::h_rnl(n1,l1,r1));
-								return h_rnl * h_rnl
-								* std::pow(r1,2-(static_cast<double>(k)+1));
-								}, r);
-				};
+		double i_direct(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k,
+				const precision_policy &precision
+				)
+		{
+			if(precision.tier == precision_tier::fast){
+				return effz::radial::grid_direct(
+						fast_orbitals(std::max(n,n1), precision.grid_step),
+						n,l,n1,l1,k);
+			}
+			if(effz::radial::is_closed_form_direct(n,l,n1,l1,k)){
+				double error = 0.;
+				const double value =
+					effz::radial::slater_direct(n,l,n1,l1,k,&error);
+				if(precision.tier == precision_tier::standard
+						|| is_within(error, value, precision)){
+					return value;
+				}
+			}
+			return i_direct_quad_multipoles(n,l,n1,l1,{k},
+					precision.epsabs, precision.epsrel).front();
+		}
 
-			auto integral = [n,l,&inner_0_r,&inner_r_inf](double r)
-				-> double {
-					double h_rnl = effz::h_rnl(n,l,r);
-					return r * r * h_rnl * h_rnl
-						* (inner_0_r(r) + inner_r_inf(r));
+		double i_direct_quad(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k
+				)
+		{
+			return i_direct_quad_multipoles(n,l,n1,l1,{k}).front();
+		}
+
+		std::vector<double> i_direct_quad_multipoles(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const std::vector<int> &k,
+				const double epsabs,
+				const double epsrel,
+				double *abserr
+				)
+		{
+			const effz::radial::h_rnl_poly r_nl =
+				effz::radial::make_h_rnl_poly(n,l);
+			const effz::radial::h_rnl_poly r_n1l1 =
+				effz::radial::make_h_rnl_poly(n1,l1);
+
+			/*
+			 *h_rnl(n,l,r)^2 on a panel
+			 */
+			auto density = [](const effz::radial::h_rnl_poly &r_nl){
+				return [&r_nl](const double *x, double *y,
+						const std::size_t size){
+					effz::radial::h_rnl_values(r_nl, x, y, size);
+					for(std::size_t i = 0; i < size; ++i){
+						y[i] *= y[i];
+					}
 				};
+			};
 
-			return effz::integration::int_0_inf(integral);
-		}
+			const effz::integration::decay density_decay =
+				{2. * r_nl.alpha, 2. * (n - 1)};
+			const effz::integration::decay density_1_decay =
+				{2. * r_n1l1.alpha, 2. * (n1 - 1)};
 
+			return multipole_quad(density(r_nl), density_decay,
+					density(r_n1l1), density_1_decay, k,
+					epsabs, epsrel, abserr);
+		}
 
+		estimate i_direct_estimate(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k,
+				const double epsabs)
+		{
+			const bool is_closed_form =
+				effz::radial::is_closed_form_direct(n,l,n1,l1,k);
+			estimate closed{0., 0.};
+			if(is_closed_form){
+				closed.value = effz::radial::slater_direct(n,l,n1,l1,k,
+						&closed.error);
+				if(closed.error <= epsabs
+						|| is_rounding_limited(closed)){
+					return closed;
+				}
+			}
+			estimate quad{0., 0.};
+			quad.value = i_direct_quad_multipoles(n,l,n1,l1,{k},
+					epsabs, 0., &quad.error).front();
+			return (is_closed_form && closed.error <= quad.error)
+				? closed : quad;
+		}
 
 		double i_direct_data_test(
 				const int n,
@@ -432,8 +348,7 @@ namespace effz {
 				const int l1,
 				const int k)
 		{
-			i_direct_database dat;
-			return dat.get_i_direct(n,l,n1,l1,k);
+			return i_direct_database::shared()->get_i_direct(n,l,n1,l1,k);
 		}
 
 		double three_j_prod_exchange(
@@ -444,17 +359,25 @@ namespace effz {
 				const int k)
 		{
 			const int q = m1 - m;
-			const bool is_q_between =
-				effz::in_range<int>(-k,k,q);
-			if(!is_q_between){
+			if(!effz::in_range<int>(-k,k,q) || (l + l1 + k) % 2 != 0
+					|| k < std::abs(l - l1) || k > l + l1){
 				return 0.;
 			}
+			if(is_small(l,l1)){
+				const double c = small_c_k.c_k(l,m,l1,m1,k);
+				return c * c;
+			}
+			const three_j_table &table = three_j_table::shared();
+			if(table.is_tabulated(l,l1)){
+				const double c = table.c_k(l,m,l1,m1,k);
+				return c * c;
+			}
 			int prefactor = ((l + l1 + k)%2 == 0) ? 1 : -1;
 			prefactor *= (2 * l + 1) * (2 * l1 + 1);
 			const double three_j_1 =
-				effz::three_j_symbol({{{l1,l,k},{0,0,0}}});
+				effz::three_j_symbol(l1,l,k,0,0,0);
 			const double three_j_2 =
-				effz::three_j_symbol({{{l1,l,k},{-m1,m,q}}});
+				effz::three_j_symbol(l1,l,k,-m1,m,q);
 
 			return static_cast<double>(prefactor)
 				* three_j_1 * three_j_2 * three_j_1 * three_j_2;
@@ -468,46 +391,157 @@ namespace effz {
 				const int k
 				)
 		{
-			auto inner_0_r =
-				[n,l,n1,l1,k](double r) -> double {
-					return 1. / std::pow(r, static_cast<double>(k) + 1)
-						* effz::integration::quad(
-								[n,l,n1,l1,k](double r1) -> double {
-								double h_rnl =
-								effz::h_rnl(n,l,r1);
-								double h_rnl1 =
-								effz::h_rnl(n1,l1,r1);
-								return h_rnl * h_rnl1
-								* std::pow(r1,static_cast<double>(k) + 2);
-								},
-								{0.,r});
-				};
+			return i_exchange(n,l,n1,l1,k,precision_policy::standard());
+		}
 
-			auto inner_r_inf =
-				[n,l,n1,l1,k](double r) -> double {
-					return std::pow(r, static_cast<double>(k))
-						* effz::integration::int_r_inf(
-								[n,l,n1,l1,k](double r1) -> double {
-								double h_rnl =
-								effz::h_rnl(n,l,r1);
-								double h_rnl1 =
-								effz::h_rnl(n1,l1,r1);
-								return h_rnl * h_rnl1
-								* std::pow(r1,2-(static_cast<double>(k)+1));
-								}, r);
-				};
+		double i_exchange(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k,
+				const precision_policy &precision
+				)
+		{
+			if(precision.tier == precision_tier::fast){
+				return effz::radial::grid_exchange(
+						fast_orbitals(std::max(n,n1), precision.grid_step),
+						n,l,n1,l1,k);
+			}
+			if(effz::radial::is_closed_form_exchange(n,l,n1,l1,k)){
+				double error = 0.;
+				const double value =
+					effz::radial::slater_exchange(n,l,n1,l1,k,&error);
+				if(precision.tier == precision_tier::standard
+						|| is_within(error, value, precision)){
+					return value;
+				}
+			}
+			return i_exchange_quad_multipoles(n,l,n1,l1,{k},
+					precision.epsabs, precision.epsrel).front();
+		}
 
-			auto integral =	[n,l,n1,l1,&inner_0_r,&inner_r_inf](double r)
-				-> double {
-					double h_rnl = effz::h_rnl(n,l,r);
-					double h_rnl1 = effz::h_rnl(n1,l1,r);
-					return r * r * h_rnl1 * h_rnl
-						* (inner_0_r(r) + inner_r_inf(r));
-				};
+		double i_exchange_quad(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k
+				)
+		{
+			return i_exchange_quad_multipoles(n,l,n1,l1,{k}).front();
+		}
 
-			return effz::integration::int_0_inf(integral);
+		std::vector<double> i_exchange_quad_multipoles(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const std::vector<int> &k,
+				const double epsabs,
+				const double epsrel,
+				double *abserr
+				)
+		{
+			const effz::radial::h_rnl_poly r_nl =
+				effz::radial::make_h_rnl_poly(n,l);
+			const effz::radial::h_rnl_poly r_n1l1 =
+				effz::radial::make_h_rnl_poly(n1,l1);
+
+			/*
+			 *h_rnl(n,l,r) h_rnl(n1,l1,r) on a panel
+			 */
+			auto pair_density = [&r_nl,&r_n1l1](const double *x,
+					double *y, const std::size_t size){
+				double h_rnl1[effz::integration::max_panel_nodes];
+				effz::radial::h_rnl_values(r_nl, x, y, size);
+				effz::radial::h_rnl_values(r_n1l1, x, h_rnl1, size);
+				for(std::size_t i = 0; i < size; ++i){
+					y[i] *= h_rnl1[i];
+				}
+			};
+
+			const effz::integration::decay pair_decay =
+				{r_nl.alpha + r_n1l1.alpha, static_cast<double>(n + n1 - 2)};
+
+			return multipole_quad(pair_density, pair_decay,
+					pair_density, pair_decay, k,
+					epsabs, epsrel, abserr);
 		}
 
+		estimate i_exchange_estimate(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k,
+				const double epsabs)
+		{
+			const bool is_closed_form =
+				effz::radial::is_closed_form_exchange(n,l,n1,l1,k);
+			estimate closed{0., 0.};
+			if(is_closed_form){
+				closed.value = effz::radial::slater_exchange(n,l,n1,l1,k,
+						&closed.error);
+				if(closed.error <= epsabs
+						|| is_rounding_limited(closed)){
+					return closed;
+				}
+			}
+			estimate quad{0., 0.};
+			quad.value = i_exchange_quad_multipoles(n,l,n1,l1,{k},
+					epsabs, 0., &quad.error).front();
+			return (is_closed_form && closed.error <= quad.error)
+				? closed : quad;
+		}
+
+		namespace {
+
+			std::atomic<unsigned long long> num_evaluated(0);
+			std::atomic<unsigned long long> num_pruned(0);
+
+			/*
+			 *counts the terms of one interaction sum and publishes
+			 *them with one atomic add each when it goes out of scope
+			 */
+			class term_counter{
+				private:
+					unsigned long long evaluated;
+					unsigned long long pruned;
+				public:
+					term_counter() : evaluated(0), pruned(0) {}
+
+					~term_counter(){
+						num_evaluated.fetch_add(evaluated,
+								std::memory_order_relaxed);
+						num_pruned.fetch_add(pruned,
+								std::memory_order_relaxed);
+					}
+
+					bool is_pruned(const double angular){
+						++evaluated;
+						if(angular == 0.){
+							++pruned;
+							return true;
+						}
+						return false;
+					}
+			};
+
+		} /* end anonymous namespace */
+
+		screening_counters get_screening_counters()
+		{
+			return screening_counters{
+				num_evaluated.load(std::memory_order_relaxed),
+				num_pruned.load(std::memory_order_relaxed)};
+		}
+
+		void reset_screening_counters()
+		{
+			num_evaluated.store(0, std::memory_order_relaxed);
+			num_pruned.store(0, std::memory_order_relaxed);
+		}
 
 		double v_direct(
 				const int n,
@@ -519,9 +553,11 @@ namespace effz {
 		{
 			int k_boundary = std::min(l,l1);
 			double sum = 0.;
+			term_counter counter;
 			for(int k = 0; k <= k_boundary; ++k){
-				sum += 0.5 * i_direct(n,l,n1,l1,2 * k)
-					* three_j_prod_direct(l,m,l1,m1,2 * k);
+				const double angular = three_j_prod_direct(l,m,l1,m1,2 * k);
+				if(counter.is_pruned(angular)){continue;}
+				sum += 0.5 * i_direct(n,l,n1,l1,2 * k) * angular;
 			}
 			return sum;
 		}
@@ -537,112 +573,491 @@ namespace effz {
 			int k_min = std::abs(l1 - l);
 			int k_max = l1 + l;
 			double sum = 0.;
+			term_counter counter;
 			for(int k = k_min; k <= k_max; ++k){
-				sum += 0.5 * i_exchange(n,l,n1,l1,k)
-					* three_j_prod_exchange(l,m,l1,m1,k);
+				const double angular = three_j_prod_exchange(l,m,l1,m1,k);
+				if(counter.is_pruned(angular)){continue;}
+				sum += 0.5 * i_exchange(n,l,n1,l1,k) * angular;
 			}
 			return sum;
 		}
 
-		double v_direct_total(const occ_nums_array &g)
+		void compress_subshells(const occ_nums_array &g,
+				subshell_array &out)
 		{
-			i_direct_database i_d;
-			double sum = 0.;
-			for(auto &g_i: g){
-				for(auto &g_j: g){
-					int n = g_i[0], l = g_i[1], m = g_i[2];
-					int n1 = g_j[0], l1 = g_j[1], m1 = g_j[2];
-
-					int k_boundary = std::min(l,l1);
-					double sum_d = 0.;
-					for(int k = 0; k <= k_boundary; ++k){
-						sum_d += 0.5 * i_d.get_i_direct(n,l,n1,l1,2 * k)
-							* three_j_prod_direct(l,m,l1,m1,2 * k);
-					}
-
-					sum += sum_d;
+			out.clear();
+			for(const auto &g_i: g){
+				const int n = g_i[0], l = g_i[1], m = g_i[2];
+				if(l < 0 || l > subshell::max_l || m < -l || m > l){
+					throw std::invalid_argument(
+							"compress_subshells: bad l or m");
+				}
+				auto it = std::find_if(out.begin(), out.end(),
+						[n,l](const subshell &sh){
+							return sh.n == n && sh.l == l;
+						});
+				if(it == out.end()){
+					out.push_back(subshell{n, l, 0, 0});
+					it = out.end() - 1;
+				}
+				const std::uint64_t bit = std::uint64_t(1) << (m + l);
+				if(g_i[3] > 0){
+					it->m_up |= bit;
+				} else {
+					it->m_down |= bit;
 				}
 			}
-			return sum;
 		}
 
-		double v_exchange_total(const occ_nums_array &g)
+		subshell_array compress_subshells(const occ_nums_array &g)
 		{
-			i_exchange_database i_e;
-			double sum = 0.;
-			for(auto &g_i: g){
-				for(auto &g_j: g){
-					if(g_i[3] != g_j[3]){continue;}
+			subshell_array res;
+			compress_subshells(g, res);
+			return res;
+		}
+
+		namespace {
+
+			/*
+			 *three_j_prod_direct(l,m,l1,m1,k) is
+			 *direct_factor(l,m,k) * direct_factor(l1,m1,k) with
+			 *    direct_factor(l,m,k) = (-1)^m (2l+1)
+			 *        (l l k; 0 0 0) (l l k; m -m 0)
+			 *which is 1 for k = 0 and sums to 0 over a closed
+			 *subshell for k > 0.
+			 */
+			double direct_factor(const int l, const int m, const int k)
+			{
+				if(is_small(l,l)){
+					return small_c_k.c_k(l,m,l,m,k);
+				}
+				const three_j_table &table = three_j_table::shared();
+				if(table.is_tabulated(l,l)){
+					return table.c_k(l,m,l,m,k);
+				}
+				const double three_j_1 =
+					effz::three_j_symbol(l,l,k,0,0,0);
+				const double three_j_2 =
+					effz::three_j_symbol(l,l,k,m,-m,0);
+				const double sign = (m % 2 == 0) ? 1. : -1.;
+				return sign * static_cast<double>(2 * l + 1)
+					* three_j_1 * three_j_2;
+			}
+
+			bool has_m(const std::uint64_t mask, const int l, const int m)
+			{
+				return (mask >> (m + l)) & 1u;
+			}
+
+			/*
+			 *sum of direct_factor(l,m,2k) over the electrons of each
+			 *subshell, k = 0, ..., l. Subshell i owns
+			 *values[offsets[i]], ..., values[offsets[i] + l].
+			 *Kept per thread and reused, so no allocation happens once
+			 *the buffers are large enough.
+			 */
+			struct direct_factor_table{
+				std::vector<double> values;
+				std::vector<std::size_t> offsets;
+
+				const double* operator[](const std::size_t i) const
+				{
+					return values.data() + offsets[i];
+				}
+			};
 
-					int n = g_i[0], l = g_i[1], m = g_i[2];
-					int n1 = g_j[0], l1 = g_j[1], m1 = g_j[2];
+			const direct_factor_table& direct_factors(
+					const subshell_array &shells)
+			{
+				thread_local direct_factor_table res;
+				res.offsets.resize(shells.size());
+				std::size_t size = 0;
+				for(std::size_t i = 0; i < shells.size(); ++i){
+					res.offsets[i] = size;
+					size += static_cast<std::size_t>(shells[i].l + 1);
+				}
+				res.values.assign(size, 0.);
+				for(std::size_t i = 0; i < shells.size(); ++i){
+					const subshell &sh = shells[i];
+					double *c = res.values.data() + res.offsets[i];
+					c[0] = static_cast<double>(sh.occupation());
+					if(sh.is_closed()){
+						continue;
+					}
+					for(int m = -sh.l; m <= sh.l; ++m){
+						const int count = has_m(sh.m_up, sh.l, m)
+							+ has_m(sh.m_down, sh.l, m);
+						if(count == 0){
+							continue;
+						}
+						for(int k = 1; k <= sh.l; ++k){
+							c[k] += count * direct_factor(sh.l, m, 2 * k);
+						}
+					}
+				}
+				return res;
+			}
 
-					int k_min = std::abs(l1 - l);
-					int k_max = l1 + l;
+			/*
+			 *direct interaction of all electrons of a with all
+			 *electrons of b
+			 */
+			double v_direct_pair(
+					const i_direct_database &i_d,
+					const subshell &a,
+					const double *c_a,
+					const subshell &b,
+					const double *c_b)
+			{
+				const int k_boundary = std::min(a.l,b.l);
+				double sum_d = 0.;
+				term_counter counter;
+				for(int k = 0; k <= k_boundary; ++k){
+					const double c = c_a[k] * c_b[k];
+					if(counter.is_pruned(c)){continue;}
+					sum_d += 0.5 * i_d.get_i_direct(a.n,a.l,b.n,b.l,2 * k) * c;
+				}
+				return sum_d;
+			}
 
-					double sum_e = 0.;
-					for(int k = k_min; k <= k_max; ++k){
-						sum_e += 0.5 * i_e.get_i_exchange(n,l,n1,l1,k)
-							* three_j_prod_exchange(l,m,l1,m1,k);
+			/*
+			 *sum of three_j_prod_exchange over pairs of m, m1 with
+			 *m in mask_a and m1 in mask_b
+			 */
+			double exchange_angular(
+					const int l,
+					const std::uint64_t mask_a,
+					const int l1,
+					const std::uint64_t mask_b,
+					const int k)
+			{
+				double sum = 0.;
+				for(int m = -l; m <= l; ++m){
+					if(!has_m(mask_a, l, m)){continue;}
+					for(int m1 = -l1; m1 <= l1; ++m1){
+						if(!has_m(mask_b, l1, m1)){continue;}
+						sum += three_j_prod_exchange(l,m,l1,m1,k);
 					}
-					sum += sum_e;
 				}
+				return sum;
 			}
-			return sum;
+
+			/*
+			 *angular factor of the exchange of all electrons of a with
+			 *the electrons of the same spin in b. Summed over a closed
+			 *subshell b, which has 2l1+1 electrons of each spin,
+			 *    sum_m1 three_j_prod_exchange(l,m,l1,m1,k)
+			 *        = (2l1+1) (l l1 k; 0 0 0)^2
+			 *for every m, so only open pairs need the explicit sum.
+			 */
+			double exchange_coefficient(
+					const subshell &a,
+					const subshell &b,
+					const int k)
+			{
+				/*
+				 *(l l1 k; 0 0 0) vanishes for odd l + l1 + k
+				 */
+				if((a.l + b.l + k) % 2 != 0){
+					return 0.;
+				}
+				if(b.is_closed() || a.is_closed()){
+					const double three_j =
+						effz::three_j_symbol(a.l,b.l,k,0,0,0);
+					const double angular = b.is_closed()
+						? static_cast<double>(
+								a.occupation() * (2 * b.l + 1))
+						: static_cast<double>(
+								b.occupation() * (2 * a.l + 1));
+					return angular * three_j * three_j;
+				}
+				return exchange_angular(a.l, a.m_up, b.l, b.m_up, k)
+					+ exchange_angular(a.l, a.m_down, b.l, b.m_down, k);
+			}
+
+			double v_exchange_pair(
+					const i_exchange_database &i_e,
+					const subshell &a,
+					const subshell &b)
+			{
+				const int k_min = std::abs(b.l - a.l);
+				const int k_max = b.l + a.l;
+				double sum_e = 0.;
+				term_counter counter;
+				for(int k = k_min; k <= k_max; ++k){
+					const double angular = exchange_coefficient(a,b,k);
+					if(counter.is_pruned(angular)){continue;}
+					sum_e += 0.5 * i_e.get_i_exchange(a.n,a.l,b.n,b.l,k)
+						* angular;
+				}
+				return sum_e;
+			}
+
+			/*
+			 *compressed g, reused by the calling thread
+			 */
+			const subshell_array& scratch_subshells(const occ_nums_array &g)
+			{
+				thread_local subshell_array shells;
+				compress_subshells(g, shells);
+				return shells;
+			}
+
+			/*
+			 *coefficient times radial integral I(n,l,n1,l1,k)
+			 */
+			struct budget_term{
+				double coefficient;
+				int n;
+				int l;
+				int n1;
+				int l1;
+				int k;
+			};
+
+			typedef estimate (*radial_estimate)(const int, const int,
+					const int, const int, const int, const double);
+
+			/*
+			 *sum of the terms with epsabs split evenly over them.
+			 *The terms are summed with compensation, so the rounding
+			 *is one epsilon of the sum of |terms| for the products,
+			 *two of the result and a second order part, instead of
+			 *terms.size() epsilons of the sum of |terms|.
+			 */
+			estimate budgeted_sum(const std::vector<budget_term> &terms,
+					const radial_estimate integral,
+					const double epsabs)
+			{
+				const double num_terms = static_cast<double>(terms.size());
+				effz::parallel::neumaier_sum<double> sum;
+				estimate res{0., 0.};
+				double abs_sum = 0.;
+				for(auto &t: terms){
+					const double c = std::abs(t.coefficient);
+					const estimate i = integral(t.n,t.l,t.n1,t.l1,t.k,
+							epsabs / (num_terms * c));
+					sum.add(t.coefficient * i.value);
+					res.error += c * i.error;
+					abs_sum += std::abs(t.coefficient * i.value);
+				}
+				res.value = sum.value();
+				const double eps = std::numeric_limits<double>::epsilon();
+				res.error += eps * abs_sum + 2. * eps * std::abs(res.value)
+					+ num_terms * eps * eps * abs_sum;
+				return res;
+			}
+
+			int popcount(std::uint64_t x)
+			{
+				int res = 0;
+				for(; x != 0; x &= x - 1){
+					++res;
+				}
+				return res;
+			}
+
+		} /* end anonymous namespace */
+
+		int subshell::occupation() const
+		{
+			return popcount(m_up) + popcount(m_down);
 		}
 
-		double v_direct_total_par(const occ_nums_array &g)
+		bool subshell::is_closed() const
+		{
+			return occupation() == 2 * (2 * l + 1);
+		}
+
+		double v_direct_total(const subshell_array &shells)
+		{
+			return v_direct_total(shells, precision_policy::standard());
+		}
+
+		double v_exchange_total(const subshell_array &shells)
 		{
+			return v_exchange_total(shells, precision_policy::standard());
+		}
+
+		double v_direct_total_par(const subshell_array &shells)
+		{
+			return v_direct_total_par(shells, precision_policy::standard());
+		}
+
+		double v_exchange_total_par(const subshell_array &shells)
+		{
+			return v_exchange_total_par(shells,
+					precision_policy::standard());
+		}
+
+		double v_direct_total(const subshell_array &shells,
+				const precision_policy &precision)
+		{
+			const auto i_d = i_direct_database::shared(precision.tier);
+			const direct_factor_table &c = direct_factors(shells);
 			double sum = 0.;
-			std::vector<std::array<int,6>>
-				occ_nums_array;
-			for(auto &g_i: g){
-				for(auto &g_j: g){
-					occ_nums_array.push_back({ g_i[0], g_i[1], g_i[2],
-							g_j[0], g_j[1], g_j[2]});
+			for(std::size_t i = 0; i < shells.size(); ++i){
+				for(std::size_t j = 0; j < shells.size(); ++j){
+					sum += v_direct_pair(*i_d, shells[i], c[i],
+							shells[j], c[j]);
 				}
 			}
-			auto lambda = [](const std::array<int,6>& g_i){
-				return v_direct(g_i[0], g_i[1], g_i[2], g_i[3],
-						g_i[4], g_i[5]);
-			};
-			sum = effz::parallel::parallel_sum<double>(
-					occ_nums_array, lambda);
-
 			return sum;
 		}
 
-		double v_exchange_total_par(const occ_nums_array &g)
+		double v_exchange_total(const subshell_array &shells,
+				const precision_policy &precision)
 		{
+			const auto i_e = i_exchange_database::shared(precision.tier);
 			double sum = 0.;
-			std::vector<std::array<int,8>>
-				occ_nums_array;
-			for(auto &g_i: g){
-				for(auto &g_j: g){
-					occ_nums_array.push_back({
-							g_i[0], g_i[1], g_i[2], g_i[3],
-							g_j[0], g_j[1], g_j[2], g_j[3]});
+			for(auto &a: shells){
+				for(auto &b: shells){
+					sum += v_exchange_pair(*i_e, a, b);
 				}
 			}
-			auto lambda = [](const std::array<int,8>& g_i){
-				return (g_i[3] != g_i[7]) ? 0 :
-					v_exchange(g_i[0], g_i[1], g_i[2], g_i[4],
-							g_i[5], g_i[6]);
-			};
-			sum = effz::parallel::parallel_sum<double>(
-					occ_nums_array, lambda);
-
 			return sum;
 		}
 
+		/*
+		 *the shared databases are safe for concurrent reads, each
+		 *task sums a block of subshell pairs. The deterministic
+		 *reduction gives the same bits on any number of cores.
+		 *
+		 *shells and c may be the thread_local buffers of
+		 *scratch_subshells and direct_factors. The reduction runs
+		 *isolated, so while this thread waits for it, it can not pick
+		 *up an outer task (e.g. another v_total_par of a parallel
+		 *loop over configurations) that would overwrite them.
+		 */
+		double v_direct_total_par(const subshell_array &shells,
+				const precision_policy &precision)
+		{
+			const auto i_d = i_direct_database::shared(precision.tier);
+			const direct_factor_table &c = direct_factors(shells);
+			return tbb::this_task_arena::isolate([&i_d, &shells, &c](){
+					return effz::parallel::parallel_sum_2d<double>(
+							shells.size(), shells.size(),
+							[&i_d, &shells, &c](const std::size_t i,
+								const std::size_t j){
+								return v_direct_pair(*i_d, shells[i], c[i],
+										shells[j], c[j]);
+							},
+							effz::parallel::summation::deterministic);
+					});
+		}
+
+		double v_exchange_total_par(const subshell_array &shells,
+				const precision_policy &precision)
+		{
+			const auto i_e = i_exchange_database::shared(precision.tier);
+			return tbb::this_task_arena::isolate([&i_e, &shells](){
+					return effz::parallel::parallel_sum_2d<double>(
+							shells.size(), shells.size(),
+							[&i_e, &shells](const std::size_t i,
+								const std::size_t j){
+								return v_exchange_pair(*i_e,
+										shells[i], shells[j]);
+							},
+							effz::parallel::summation::deterministic);
+					});
+		}
+
+		double v_direct_total(const occ_nums_array &g)
+		{
+			return v_direct_total(scratch_subshells(g));
+		}
+
+		double v_exchange_total(const occ_nums_array &g)
+		{
+			return v_exchange_total(scratch_subshells(g));
+		}
+
+		double v_direct_total_par(const occ_nums_array &g)
+		{
+			return v_direct_total_par(scratch_subshells(g));
+		}
+
+		double v_exchange_total_par(const occ_nums_array &g)
+		{
+			return v_exchange_total_par(scratch_subshells(g));
+		}
+
 		double v_total(const occ_nums_array &g)
 		{
-			return v_direct_total(g) - v_exchange_total(g);
+			return v_total(g, precision_policy::standard());
 		}
 
 		double v_total_par(const occ_nums_array &g)
 		{
-			return v_direct_total_par(g) - v_exchange_total_par(g);
+			return v_total_par(g, precision_policy::standard());
+		}
+
+		double v_total(const occ_nums_array &g,
+				const precision_policy &precision)
+		{
+			const subshell_array &shells = scratch_subshells(g);
+			return v_direct_total(shells, precision)
+				- v_exchange_total(shells, precision);
+		}
+
+		double v_total_par(const occ_nums_array &g,
+				const precision_policy &precision)
+		{
+			const subshell_array &shells = scratch_subshells(g);
+			return v_direct_total_par(shells, precision)
+				- v_exchange_total_par(shells, precision);
+		}
+
+		estimate v_direct_total_estimate(const subshell_array &shells,
+				const double epsabs)
+		{
+			const direct_factor_table &c = direct_factors(shells);
+			std::vector<budget_term> terms;
+			term_counter counter;
+			for(std::size_t i = 0; i < shells.size(); ++i){
+				for(std::size_t j = 0; j < shells.size(); ++j){
+					const subshell &a = shells[i];
+					const subshell &b = shells[j];
+					for(int k = 0; k <= std::min(a.l,b.l); ++k){
+						const double coefficient = 0.5 * c[i][k] * c[j][k];
+						if(counter.is_pruned(coefficient)){continue;}
+						terms.push_back(budget_term{
+								coefficient, a.n, a.l, b.n, b.l, 2 * k});
+					}
+				}
+			}
+			return budgeted_sum(terms, &i_direct_estimate, epsabs);
+		}
+
+		estimate v_exchange_total_estimate(const subshell_array &shells,
+				const double epsabs)
+		{
+			std::vector<budget_term> terms;
+			term_counter counter;
+			for(auto &a: shells){
+				for(auto &b: shells){
+					for(int k = std::abs(b.l - a.l); k <= b.l + a.l; ++k){
+						const double coefficient =
+							0.5 * exchange_coefficient(a,b,k);
+						if(counter.is_pruned(coefficient)){continue;}
+						terms.push_back(budget_term{
+								coefficient, a.n, a.l, b.n, b.l, k});
+					}
+				}
+			}
+			return budgeted_sum(terms, &i_exchange_estimate, epsabs);
+		}
+
+		estimate v_total_estimate(const occ_nums_array &g,
+				const double epsabs)
+		{
+			const subshell_array &shells = scratch_subshells(g);
+			const estimate direct =
+				v_direct_total_estimate(shells, 0.5 * epsabs);
+			const estimate exchange =
+				v_exchange_total_estimate(shells, 0.5 * epsabs);
+			return estimate{direct.value - exchange.value,
+				direct.error + exchange.error};
 		}
 
 		double a(const occ_nums_array &g)
@@ -657,31 +1072,86 @@ namespace effz {
 
 		double z_star_0th(double z, const occ_nums_array &g)
 		{
-			return z - v_total(g) / (2. * a(g));
+			return z_star_0th(z, g, precision_policy::standard());
 		}
 
 		double e_0th(double z,const occ_nums_array &g)
 		{
-			double z_star = z_star_0th(z,g);
-			return -a(g) * z_star * z_star;
+			return e_0th(z, g, precision_policy::standard());
 		}
 
 		double z_star_0th_par(double z, const occ_nums_array &g)
 		{
-			return z - v_total_par(g) / (2. * a(g));
+			return z_star_0th_par(z, g, precision_policy::standard());
 		}
 
 		double e_0th_par(double z, const occ_nums_array &g)
 		{
-			double z_star = z_star_0th_par(z,g);
+			return e_0th_par(z, g, precision_policy::standard());
+		}
+
+		double z_star_0th(double z, const occ_nums_array &g,
+				const precision_policy &precision)
+		{
+			return z - v_total(g, precision) / (2. * a(g));
+		}
+
+		double e_0th(double z, const occ_nums_array &g,
+				const precision_policy &precision)
+		{
+			double z_star = z_star_0th(z,g,precision);
+			return -a(g) * z_star * z_star;
+		}
+
+		double z_star_0th_par(double z, const occ_nums_array &g,
+				const precision_policy &precision)
+		{
+			return z - v_total_par(g, precision) / (2. * a(g));
+		}
+
+		double e_0th_par(double z, const occ_nums_array &g,
+				const precision_policy &precision)
+		{
+			double z_star = z_star_0th_par(z,g,precision);
 			return -a(g) * z_star * z_star;
 		}
 
+		/*
+		 *z_star = z - v / (2a), so v is needed to 2a epsabs
+		 */
+		estimate z_star_0th_estimate(double z, const occ_nums_array &g,
+				const double epsabs)
+		{
+			const double a_g = a(g);
+			const estimate v = v_total_estimate(g, 2. * a_g * epsabs);
+			return estimate{z - v.value / (2. * a_g), v.error / (2. * a_g)};
+		}
+
+		/*
+		 *e = -a z_star^2 changes by 2a |z_star| dz_star, z_star is
+		 *not known in advance and bounded by z
+		 */
+		estimate e_0th_estimate(double z, const occ_nums_array &g,
+				const double epsabs)
+		{
+			const double a_g = a(g);
+			const estimate z_star = z_star_0th_estimate(z, g,
+					epsabs / (2. * a_g * std::max(std::abs(z), 1.)));
+			return estimate{-a_g * z_star.value * z_star.value,
+				2. * a_g * std::abs(z_star.value) * z_star.error};
+		}
+
 		std::tuple<double,double> z_star_and_e_0th_par(double z,
 				const occ_nums_array &g)
 		{
-			//double z_star = z_star_0th_par(z,g);
-			double z_star = z_star_0th(z,g);
+			return z_star_and_e_0th_par(z, g, precision_policy::standard());
+		}
+
+		std::tuple<double,double> z_star_and_e_0th_par(double z,
+				const occ_nums_array &g,
+				const precision_policy &precision)
+		{
+			double z_star = z_star_0th_par(z,g,precision);
 			return std::make_tuple(z_star, -a(g) * z_star * z_star);
 		}
 
@@ -731,6 +1201,16 @@ double effz_i_direct(
 	return effz::zeroth_order::i_direct(n,l,n1,l1,k);
 }
 
+double effz_i_direct_quad(
+		const int n,
+		const int l,
+		const int n1,
+		const int l1,
+		const int k)
+{
+	return effz::zeroth_order::i_direct_quad(n,l,n1,l1,k);
+}
+
 double effz_three_j_prod_exchange(
 		const int l,
 		const int m,
@@ -751,6 +1231,16 @@ double effz_i_exchange(
 	return effz::zeroth_order::i_exchange(n,l,n1,l1,k);
 }
 
+double effz_i_exchange_quad(
+		const int n,
+		const int l,
+		const int n1,
+		const int l1,
+		const int k)
+{
+	return effz::zeroth_order::i_exchange_quad(n,l,n1,l1,k);
+}
+
 double effz_v_direct(
 		const int n,
 		const int l,
@@ -773,6 +1263,19 @@ double effz_v_exchange(
 	return effz::zeroth_order::v_exchange(n,l,m,n1,l1,m1);
 }
 
+void effz_get_screening_counters(unsigned long long *evaluated,
+		unsigned long long *pruned)
+{
+	const auto counters = effz::zeroth_order::get_screening_counters();
+	*evaluated = counters.evaluated;
+	*pruned = counters.pruned;
+}
+
+void effz_reset_screening_counters()
+{
+	effz::zeroth_order::reset_screening_counters();
+}
+
 double effz_v_direct_total(const effz_occ_num_t *g, size_t dim)
 {
 	effz::occ_nums_array arr = effz::c_occ_nums_to_cpp(g,dim);
@@ -809,6 +1312,15 @@ double effz_v_total_par(const effz_occ_num_t *g, size_t dim)
 	return effz::zeroth_order::v_total_par(arr);
 }
 
+double effz_v_total_estimate(const effz_occ_num_t *g, size_t dim,
+		double epsabs, double *abserr)
+{
+	effz::occ_nums_array arr = effz::c_occ_nums_to_cpp(g,dim);
+	const auto res = effz::zeroth_order::v_total_estimate(arr,epsabs);
+	*abserr = res.error;
+	return res.value;
+}
+
 double effz_a(const effz_occ_num_t *g, size_t dim)
 {
 	effz::occ_nums_array arr = effz::c_occ_nums_to_cpp(g,dim);
@@ -827,6 +1339,45 @@ double effz_e_0th(double z, const effz_occ_num_t *g, size_t dim)
 	return effz::zeroth_order::e_0th(z,arr);
 }
 
+double effz_e_0th_estimate(double z, const effz_occ_num_t *g,
+		size_t dim, double epsabs, double *abserr)
+{
+	effz::occ_nums_array arr = effz::c_occ_nums_to_cpp(g,dim);
+	const auto res = effz::zeroth_order::e_0th_estimate(z,arr,epsabs);
+	*abserr = res.error;
+	return res.value;
+}
+
+namespace {
+
+	effz::zeroth_order::precision_policy c_precision(const int tier)
+	{
+		switch(tier){
+			case 0:
+				return effz::zeroth_order::precision_policy::fast();
+			case 2:
+				return effz::zeroth_order::precision_policy::reference();
+			default:
+				return effz::zeroth_order::precision_policy::standard();
+		}
+	}
+
+} /* end anonymous namespace */
+
+double effz_z_star_0th_tier(double z, const effz_occ_num_t *g,
+		size_t dim, int tier)
+{
+	effz::occ_nums_array arr = effz::c_occ_nums_to_cpp(g,dim);
+	return effz::zeroth_order::z_star_0th(z,arr,c_precision(tier));
+}
+
+double effz_e_0th_tier(double z, const effz_occ_num_t *g,
+		size_t dim, int tier)
+{
+	effz::occ_nums_array arr = effz::c_occ_nums_to_cpp(g,dim);
+	return effz::zeroth_order::e_0th(z,arr,c_precision(tier));
+}
+
 double effz_z_star_0th_par(double z,
 		const effz_occ_num_t *g, size_t dim)
 {
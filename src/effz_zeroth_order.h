@@ -20,11 +20,18 @@ limitations under the License.
 #include <effz_lib/effz_typedefs.h>
 
 #ifdef __cplusplus
+#include <effz_lib/effz_precision.h>
+
+#include <cstdint>
 
 namespace effz{
 	namespace zeroth_order{
 		/*
 		 *In this file "par" means parallel function
+		 *
+		 *i_direct and i_exchange use the closed form expressions from
+		 *effz_radial_integrals.h, *_quad are the nested numerical
+		 *quadratures kept as a reference.
 		 */
 		double three_j_prod_direct(
 				const int l,
@@ -40,6 +47,48 @@ namespace effz{
 				const int l1,
 				const int k);
 
+		double i_direct_quad(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k);
+
+		/*
+		 *i_direct and i_exchange evaluated as the tier of precision
+		 *prescribes, the functions without it use the standard tier
+		 */
+		double i_direct(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k,
+				const precision_policy &precision);
+
+		double i_exchange(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k,
+				const precision_policy &precision);
+
+		/*
+		 *i_direct_quad for every multipole in k, the radial
+		 *integrand is evaluated once per node for all of them.
+		 *abserr (if not null) receives k.size() error estimates.
+		 */
+		std::vector<double> i_direct_quad_multipoles(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const std::vector<int> &k,
+				const double epsabs = 1.49e-8,
+				const double epsrel = 1.49e-8,
+				double *abserr = nullptr);
+
 		double three_j_prod_exchange(
 				const int l,
 				const int m,
@@ -54,6 +103,76 @@ namespace effz{
 				const int l1,
 				const int k);
 
+		double i_exchange_quad(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k);
+
+		/*
+		 *i_exchange_quad for every multipole in k, the radial
+		 *integrand is evaluated once per node for all of them.
+		 *abserr (if not null) receives k.size() error estimates.
+		 */
+		std::vector<double> i_exchange_quad_multipoles(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const std::vector<int> &k,
+				const double epsabs = 1.49e-8,
+				const double epsrel = 1.49e-8,
+				double *abserr = nullptr);
+
+		/*
+		 *value and estimated absolute error
+		 */
+		struct estimate{
+			double value;
+			double error;
+		};
+
+		/*
+		 *i_direct and i_exchange with an error estimate. The closed
+		 *form is used if its rounding error bound is within epsabs or
+		 *already at the rounding of the value, otherwise the
+		 *quadrature is done to epsabs and the smaller of the two
+		 *errors wins. The error may still be above epsabs if
+		 *neither reaches it.
+		 */
+		estimate i_direct_estimate(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k,
+				const double epsabs);
+
+		estimate i_exchange_estimate(
+				const int n,
+				const int l,
+				const int n1,
+				const int l1,
+				const int k,
+				const double epsabs);
+
+		/*
+		 *terms (pair of orbitals or subshells, k) seen by the
+		 *interaction sums, and how many of them were skipped because
+		 *their angular coefficient vanishes by parity, triangle or
+		 *m selection rules. No radial integral is requested for a
+		 *skipped term.
+		 */
+		struct screening_counters{
+			unsigned long long evaluated;
+			unsigned long long pruned;
+		};
+
+		screening_counters get_screening_counters();
+
+		void reset_screening_counters();
+
 		double v_direct(
 				const int n,
 				const int l,
@@ -70,6 +189,62 @@ namespace effz{
 				const int l1,
 				const int m1);
 
+		/*
+		 *electrons of one subshell n,l: bit m + l of m_up (m_down)
+		 *is set if the spin orbital m, s > 0 (s < 0) is occupied.
+		 *A subshell with all 2(2l+1) spin orbitals occupied is
+		 *closed, its angular sums are done in closed form.
+		 */
+		struct subshell{
+			static const int max_l = 31;
+
+			int n;
+			int l;
+			std::uint64_t m_up;
+			std::uint64_t m_down;
+
+			int occupation() const;
+			bool is_closed() const;
+		};
+
+		typedef std::vector<subshell> subshell_array;
+
+		/*
+		 *group the spin orbitals of g by n,l in order of appearance,
+		 *the second form reuses the storage of out
+		 */
+		subshell_array compress_subshells(const occ_nums_array &g);
+
+		void compress_subshells(const occ_nums_array &g,
+				subshell_array &out);
+
+		/*
+		 *interaction sums over pairs of subshells, the
+		 *occ_nums_array overloads compress g first
+		 */
+		double v_direct_total(const subshell_array &shells);
+
+		double v_exchange_total(const subshell_array &shells);
+
+		double v_direct_total_par(const subshell_array &shells);
+
+		double v_exchange_total_par(const subshell_array &shells);
+
+		/*
+		 *the same with the shared databases of precision.tier
+		 */
+		double v_direct_total(const subshell_array &shells,
+				const precision_policy &precision);
+
+		double v_exchange_total(const subshell_array &shells,
+				const precision_policy &precision);
+
+		double v_direct_total_par(const subshell_array &shells,
+				const precision_policy &precision);
+
+		double v_exchange_total_par(const subshell_array &shells,
+				const precision_policy &precision);
+
 		double v_direct_total(const occ_nums_array &g);
 
 		double v_exchange_total(const occ_nums_array &g);
@@ -82,6 +257,35 @@ namespace effz{
 
 		double v_total_par(const occ_nums_array &g);
 
+		/*
+		 *interaction sums and energies with an error estimate, to an
+		 *absolute accuracy epsabs of the returned quantity. The
+		 *budget is split evenly over the nonvanishing terms, a term
+		 *c I asks for I to epsabs / (number of terms |c|), so only
+		 *as much accuracy is paid for as the result needs. The error
+		 *includes the rounding of the sums.
+		 *
+		 *The returned error is a bound, not the budget: if it is
+		 *above epsabs the tolerance was not reached, e.g. because it
+		 *is below the rounding error of the result itself (a few
+		 *epsilons of the sum of |terms|). Callers compare error
+		 *(abserr of the C functions) against epsabs.
+		 */
+		estimate v_direct_total_estimate(const subshell_array &shells,
+				const double epsabs);
+
+		estimate v_exchange_total_estimate(const subshell_array &shells,
+				const double epsabs);
+
+		estimate v_total_estimate(const occ_nums_array &g,
+				const double epsabs);
+
+		estimate z_star_0th_estimate(double z, const occ_nums_array &g,
+				const double epsabs);
+
+		estimate e_0th_estimate(double z, const occ_nums_array &g,
+				const double epsabs);
+
 		double a(const occ_nums_array &g);
 
 		double z_star_0th(double z,
@@ -96,6 +300,28 @@ namespace effz{
 		std::tuple<double,double> z_star_and_e_0th_par(double z,
 				const occ_nums_array &g);
 
+		double v_total(const occ_nums_array &g,
+				const precision_policy &precision);
+
+		double v_total_par(const occ_nums_array &g,
+				const precision_policy &precision);
+
+		double z_star_0th(double z, const occ_nums_array &g,
+				const precision_policy &precision);
+
+		double e_0th(double z, const occ_nums_array &g,
+				const precision_policy &precision);
+
+		double z_star_0th_par(double z, const occ_nums_array &g,
+				const precision_policy &precision);
+
+		double e_0th_par(double z, const occ_nums_array &g,
+				const precision_policy &precision);
+
+		std::tuple<double,double> z_star_and_e_0th_par(double z,
+				const occ_nums_array &g,
+				const precision_policy &precision);
+
 		class density_0th
 		{
 			private:
@@ -130,6 +356,13 @@ extern "C" {
 			const int l1,
 			const int k);
 
+	double effz_i_direct_quad(
+			const int n,
+			const int l,
+			const int n1,
+			const int l1,
+			const int k);
+
 	double effz_three_j_prod_exchange(
 			const int l,
 			const int m,
@@ -144,6 +377,13 @@ extern "C" {
 			const int l1,
 			const int k);
 
+	double effz_i_exchange_quad(
+			const int n,
+			const int l,
+			const int n1,
+			const int l1,
+			const int k);
+
 	double effz_v_direct(
 			const int n,
 			const int l,
@@ -160,6 +400,11 @@ extern "C" {
 			const int l1,
 			const int m1);
 
+	void effz_get_screening_counters(unsigned long long *evaluated,
+			unsigned long long *pruned);
+
+	void effz_reset_screening_counters();
+
 	double effz_v_direct_total(const effz_occ_num_t *g, size_t dim);
 
 	double effz_v_exchange_total(const effz_occ_num_t *g, size_t dim);
@@ -172,17 +417,36 @@ extern "C" {
 
 	double effz_v_total_par(const effz_occ_num_t *g, size_t dim);
 
+	/*
+	 *the error estimate is stored in abserr, a value above epsabs
+	 *means the tolerance was not reached
+	 */
+	double effz_v_total_estimate(const effz_occ_num_t *g, size_t dim,
+			double epsabs, double *abserr);
+
 	double effz_a(const effz_occ_num_t *g, size_t dim);
 
 	double effz_z_star_0th(double z, const effz_occ_num_t *g, size_t dim);
 
 	double effz_e_0th(double z, const effz_occ_num_t *g, size_t dim);
 
+	double effz_e_0th_estimate(double z, const effz_occ_num_t *g,
+			size_t dim, double epsabs, double *abserr);
+
 	double effz_z_star_0th_par(double z,
 			const effz_occ_num_t *g, size_t dim);
 
 	double effz_e_0th_par(double z, const effz_occ_num_t *g, size_t dim);
 
+	/*
+	 *tier: 0 fast, 1 standard, 2 reference
+	 */
+	double effz_z_star_0th_tier(double z, const effz_occ_num_t *g,
+			size_t dim, int tier);
+
+	double effz_e_0th_tier(double z, const effz_occ_num_t *g,
+			size_t dim, int tier);
+
 	/*
 	 *density_0th class start
 	 */